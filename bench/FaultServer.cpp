@@ -0,0 +1,327 @@
+#include "FaultServer.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <string>
+
+namespace
+{
+    struct Faults
+    {
+        int code = 200;
+        double flap = 0;
+        double reset = 0;
+        // latency
+        char shape = 0; // 0 none, 'f' fixed, 'u' uniform, 'l' log-normal
+        double a = 0;
+        double b = 0;
+        int stallMs = 0;
+        int redirect = 0;
+        size_t body = 2;
+        std::string mark;
+        size_t markAt = 0;
+    };
+
+    std::string_view param(std::string_view query, std::string_view name)
+    {
+        while (!query.empty())
+        {
+            auto amp = query.find('&');
+            auto pair = query.substr(0, amp);
+            auto eq = pair.find('=');
+            if (pair.substr(0, eq) == name)
+                return eq == std::string_view::npos ? std::string_view{} : pair.substr(eq + 1);
+            if (amp == std::string_view::npos)
+                break;
+            query.remove_prefix(amp + 1);
+        }
+        return {};
+    }
+
+    double number(std::string_view text, double fallback = 0)
+    {
+        if (text.empty())
+            return fallback;
+        return std::strtod(std::string(text).c_str(), nullptr);
+    }
+
+    Faults parseFaults(std::string_view query)
+    {
+        Faults f;
+        f.code = static_cast<int>(number(param(query, "code"), 200));
+        f.flap = number(param(query, "flap"));
+        f.reset = number(param(query, "reset"));
+        f.stallMs = static_cast<int>(number(param(query, "stall")));
+        f.redirect = static_cast<int>(number(param(query, "redirect")));
+        f.body = static_cast<size_t>(number(param(query, "body"), 2));
+        f.mark = std::string(param(query, "mark"));
+        f.markAt = static_cast<size_t>(number(param(query, "at")));
+
+        auto latency = param(query, "latency");
+        if (latency.starts_with("ln:"))
+        {
+            latency.remove_prefix(3);
+            auto colon = latency.find(':');
+            f.shape = 'l';
+            f.a = number(latency.substr(0, colon));
+            f.b = colon == std::string_view::npos ? 0.5 : number(latency.substr(colon + 1));
+        }
+        else if (auto dash = latency.find('-'); dash != std::string_view::npos)
+        {
+            f.shape = 'u';
+            f.a = number(latency.substr(0, dash));
+            f.b = number(latency.substr(dash + 1));
+        }
+        else if (!latency.empty())
+        {
+            f.shape = 'f';
+            f.a = number(latency);
+        }
+        return f;
+    }
+
+    double delayMs(Faults const &f, std::mt19937 &rng)
+    {
+        switch (f.shape)
+        {
+        case 'f':
+            return f.a;
+        case 'u':
+            return std::uniform_real_distribution<double>(f.a, std::max(f.a, f.b))(rng);
+        case 'l':
+            return std::lognormal_distribution<double>(std::log(std::max(f.a, 0.001)), f.b)(rng);
+        default:
+            return 0;
+        }
+    }
+
+    char const *reason(int code)
+    {
+        switch (code)
+        {
+        case 200:
+            return "OK";
+        case 302:
+            return "Found";
+        case 404:
+            return "Not Found";
+        case 500:
+            return "Internal Server Error";
+        case 503:
+            return "Service Unavailable";
+        default:
+            return "Status";
+        }
+    }
+
+    bool sendAll(int fd, std::string_view data)
+    {
+        while (!data.empty())
+        {
+            auto sent = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+            if (sent <= 0)
+                return false;
+            data.remove_prefix(static_cast<size_t>(sent));
+        }
+        return true;
+    }
+
+    // Close with RST instead of FIN
+    void resetConnection(int fd)
+    {
+        linger lg{1, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+        ::close(fd);
+    }
+}
+
+bool FaultServer::start(uint16_t port)
+{
+    m_listener = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (m_listener < 0)
+        return false;
+    int one = 1;
+    ::setsockopt(m_listener, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    socklen_t len = sizeof(addr);
+    if (::bind(m_listener, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        ::listen(m_listener, 128) != 0 ||
+        ::getsockname(m_listener, reinterpret_cast<sockaddr *>(&addr), &len) != 0)
+    {
+        ::close(m_listener);
+        m_listener = -1;
+        return false;
+    }
+    m_port = ntohs(addr.sin_port);
+    m_running = true;
+    m_acceptor = std::thread([this] { acceptLoop(); });
+    return true;
+}
+
+void FaultServer::stop()
+{
+    if (!m_running.exchange(false))
+        return;
+    m_acceptor.join();
+    ::close(m_listener);
+    m_listener = -1;
+    // connection threads notice m_running within one poll interval
+    while (m_active > 0)
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+}
+
+std::string FaultServer::url(std::string_view target) const
+{
+    return "http://127.0.0.1:" + std::to_string(m_port) + std::string(target);
+}
+
+void FaultServer::acceptLoop()
+{
+    while (m_running)
+    {
+        pollfd pfd{m_listener, POLLIN, 0};
+        if (::poll(&pfd, 1, 50) <= 0)
+            continue;
+        int fd = ::accept(m_listener, nullptr, nullptr);
+        if (fd < 0)
+            continue;
+        ++m_stats.connections;
+        ++m_active;
+        std::thread([this, fd] {
+            serve(fd);
+            --m_active;
+        }).detach();
+    }
+}
+
+void FaultServer::serve(int fd)
+{
+    std::mt19937 rng(std::random_device{}());
+    std::string buffer;
+    char chunk[4096];
+
+    auto sleepMs = [this](double ms) {
+        auto until = std::chrono::steady_clock::now() + std::chrono::duration<double, std::milli>(ms);
+        while (m_running && std::chrono::steady_clock::now() < until)
+            std::this_thread::sleep_for(std::chrono::milliseconds(std::min<int>(10, static_cast<int>(ms) + 1)));
+    };
+
+    while (m_running)
+    {
+        // read one request head
+        size_t headEnd;
+        while ((headEnd = buffer.find("\r\n\r\n")) == std::string::npos)
+        {
+            pollfd pfd{fd, POLLIN, 0};
+            if (!m_running || ::poll(&pfd, 1, 50) < 0)
+            {
+                ::close(fd);
+                return;
+            }
+            if (!(pfd.revents & (POLLIN | POLLHUP)))
+                continue;
+            auto got = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (got <= 0)
+            {
+                ::close(fd);
+                return;
+            }
+            buffer.append(chunk, static_cast<size_t>(got));
+        }
+
+        std::string_view head(buffer.data(), headEnd);
+        auto lineEnd = head.find("\r\n");
+        auto line = head.substr(0, lineEnd);
+        auto method = line.substr(0, line.find(' '));
+        auto target = line.substr(method.size() + 1);
+        target = target.substr(0, target.find(' '));
+
+        // skip any request body
+        size_t bodySize = 0;
+        if (auto cl = head.find("Content-Length:"); cl != std::string_view::npos)
+            bodySize = static_cast<size_t>(std::strtoul(std::string(head.substr(cl + 15, 12)).c_str(), nullptr, 10));
+        while (buffer.size() < headEnd + 4 + bodySize)
+        {
+            auto got = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (got <= 0)
+            {
+                ::close(fd);
+                return;
+            }
+            buffer.append(chunk, static_cast<size_t>(got));
+        }
+
+        auto path = std::string(target.substr(0, target.find('?')));
+        auto query = std::string(target.find('?') == std::string_view::npos ? std::string_view{} : target.substr(target.find('?') + 1));
+        bool isHead = method == "HEAD";
+        buffer.erase(0, headEnd + 4 + bodySize);
+        ++m_stats.requests;
+
+        auto faults = parseFaults(query);
+        sleepMs(delayMs(faults, rng));
+
+        if (faults.reset > 0 && std::uniform_real_distribution<double>(0, 1)(rng) < faults.reset)
+        {
+            ++m_stats.resets;
+            resetConnection(fd);
+            return;
+        }
+
+        if (faults.redirect > 0)
+        {
+            // /r/<hops left>/... keeps the original path after the prefix
+            int left = faults.redirect;
+            if (path.starts_with("/r/"))
+                left = std::atoi(path.c_str() + 3);
+            if (left > 0)
+            {
+                ++m_stats.redirects;
+                auto location = "/r/" + std::to_string(left - 1) + "?" + query;
+                auto response = "HTTP/1.1 302 Found\r\nLocation: " + location + "\r\nContent-Length: 0\r\n\r\n";
+                if (!sendAll(fd, response))
+                    break;
+                continue;
+            }
+        }
+
+        int code = faults.code;
+        if (faults.flap > 0 && std::uniform_real_distribution<double>(0, 1)(rng) < faults.flap)
+            code = 503;
+
+        std::string body(faults.body, 'x');
+        if (!faults.mark.empty() && faults.markAt + faults.mark.size() <= body.size())
+            body.replace(faults.markAt, faults.mark.size(), faults.mark);
+        auto response = "HTTP/1.1 " + std::to_string(code) + " " + reason(code) +
+                        "\r\nContent-Type: text/plain\r\nContent-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+        if (faults.stallMs > 0)
+        {
+            ++m_stats.stalls;
+            // a slow server: half the body now, the rest much later
+            if (!isHead)
+                response += body.substr(0, body.size() / 2);
+            if (!sendAll(fd, response))
+                break;
+            sleepMs(faults.stallMs);
+            if (!isHead && !sendAll(fd, std::string_view(body).substr(body.size() / 2)))
+                break;
+            continue;
+        }
+        if (!isHead)
+            response += body;
+        if (!sendAll(fd, response))
+            break;
+    }
+    ::close(fd);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <thread>
+
+// Local HTTP/1.1 server that misbehaves on request, standing in for the
+// real services when exercising the probe pipeline. Faults are chosen per
+// request from the query string, so one server covers every scenario:
+//
+//   code=503           status to answer with (default 200)
+//   flap=0.3           chance of answering 503 instead
+//   latency=50         delay before answering, in ms
+//   latency=20-200     ... uniform in a range
+//   latency=ln:50:0.5  ... log-normal with a 50ms median and sigma 0.5
+//   reset=0.1          chance of resetting the connection instead
+//   stall=5000         send the headers and half the body, then stall (ms)
+//   redirect=3         answer through a chain of that many redirects
+//   body=1024          body size in bytes (default 2)
+//   mark=ok&at=100     write that text into the body at that offset
+//
+// Connections are kept alive between requests. POSIX only.
+class FaultServer
+{
+public:
+    struct Stats
+    {
+        std::atomic<uint64_t> connections{0};
+        std::atomic<uint64_t> requests{0};
+        std::atomic<uint64_t> resets{0};
+        std::atomic<uint64_t> stalls{0};
+        std::atomic<uint64_t> redirects{0};
+    };
+
+    FaultServer() = default;
+    FaultServer(FaultServer const &) = delete;
+    FaultServer &operator=(FaultServer const &) = delete;
+    ~FaultServer() { stop(); }
+
+    // Listen on 127.0.0.1; port 0 picks a free one
+    bool start(uint16_t port = 0);
+    void stop();
+
+    uint16_t port() const { return m_port; }
+    // "http://127.0.0.1:<port>" + target
+    std::string url(std::string_view target = "/") const;
+    Stats const &stats() const { return m_stats; }
+
+private:
+    void acceptLoop();
+    void serve(int fd);
+
+    int m_listener = -1;
+    uint16_t m_port = 0;
+    std::atomic<bool> m_running{false};
+    std::atomic<int> m_active{0};
+    std::thread m_acceptor;
+    Stats m_stats;
+};
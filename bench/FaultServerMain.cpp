@@ -0,0 +1,33 @@
+// Runs the fault server on its own so a real game can be pointed at it:
+//   servers_status_fault_server 8080
+//   SERVERS_STATUS_URL_GEODE="http://127.0.0.1:8080/?flap=0.3&latency=ln:80:0.6" <launch the game>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "FaultServer.hpp"
+
+int main(int argc, char **argv)
+{
+    auto port = static_cast<uint16_t>(argc > 1 ? std::atoi(argv[1]) : 8080);
+    FaultServer server;
+    if (!server.start(port))
+    {
+        std::fprintf(stderr, "failed to listen on port %u\n", port);
+        return 1;
+    }
+    std::printf("listening on %s\n", server.url().c_str());
+    std::fflush(stdout);
+    for (;;)
+    {
+        std::this_thread::sleep_for(std::chrono::seconds(60));
+        auto const &stats = server.stats();
+        std::printf("%llu requests, %llu resets, %llu stalls, %llu redirects\n",
+                    static_cast<unsigned long long>(stats.requests.load()),
+                    static_cast<unsigned long long>(stats.resets.load()),
+                    static_cast<unsigned long long>(stats.stalls.load()),
+                    static_cast<unsigned long long>(stats.redirects.load()));
+        std::fflush(stdout);
+    }
+}
@@ -0,0 +1,434 @@
+// Probe pipeline benchmarks against the local fault server. They drive the
+// same executor, latency histogram and per-host limits StatusMonitor (built-in
+// services, high priority) and StatusNode (custom endpoints) go through, with
+// a plain blocking HTTP client standing in for Geode's web requests, and
+// fail the run when latency or completion bounds are not met.
+#include <benchmark/benchmark.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BodyMatcher.hpp"
+#include "FaultServer.hpp"
+#include "LatencyHistogram.hpp"
+#include "Probe.hpp"
+#include "ProbeDependencies.hpp"
+#include "ProbeExecutor.hpp"
+#include "UrlParser.hpp"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+    using ms = std::chrono::milliseconds;
+
+    FaultServer &server()
+    {
+        static FaultServer instance;
+        static bool started = instance.start();
+        (void)started;
+        return instance;
+    }
+
+    // Blocking HTTP/1.1 request against 127.0.0.1, following redirects.
+    // Returns the final status, or 0 on reset, timeout or a bad response.
+    // With a matcher the body is fed to it as it arrives and reading stops
+    // as soon as it has a verdict. With a cap a Range is asked for, and a
+    // server that sends more anyway is cut off there like in the mod: 0 is
+    // returned and truncated set.
+    int fetch(std::string url, std::string const &method, ms timeout, BodyMatcher *matcher = nullptr,
+              uint32_t cap = 0, bool *truncated = nullptr)
+    {
+        auto deadline = Clock::now() + timeout;
+        for (int hops = 0; hops <= 5; ++hops)
+        {
+            auto parsed = UrlParser::parse(url);
+            if (!parsed)
+                return 0;
+            int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons(parsed->effectivePort());
+            if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) != 0)
+            {
+                ::close(fd);
+                return 0;
+            }
+
+            std::string target(parsed->path.empty() ? "/" : parsed->path);
+            if (!parsed->query.empty())
+                target += "?" + std::string(parsed->query);
+            auto range = cap > 0 ? "\r\nRange: bytes=0-" + std::to_string(cap - 1) : std::string();
+            auto request = method + " " + target + " HTTP/1.1\r\nHost: " + std::string(parsed->authority) + range +
+                           "\r\nConnection: close\r\n\r\n";
+            ::send(fd, request.data(), request.size(), MSG_NOSIGNAL);
+
+            std::string response;
+            char chunk[4096];
+            size_t fed = 0;
+            bool decided = false;
+            while (true)
+            {
+                auto left = std::chrono::duration_cast<std::chrono::microseconds>(deadline - Clock::now());
+                if (left.count() <= 0)
+                    break;
+                timeval tv{static_cast<time_t>(left.count() / 1000000), static_cast<suseconds_t>(left.count() % 1000000)};
+                ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+                auto got = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (got <= 0)
+                    break;
+                response.append(chunk, static_cast<size_t>(got));
+
+                auto headEnd = response.find("\r\n\r\n");
+                if (headEnd == std::string::npos)
+                    continue;
+                size_t length = 0;
+                if (auto cl = response.find("Content-Length: "); cl != std::string::npos && cl < headEnd)
+                    length = std::strtoul(response.c_str() + cl + 16, nullptr, 10);
+                if (cap > 0 && response.size() > headEnd + 4 + cap)
+                {
+                    ::close(fd);
+                    if (truncated)
+                        *truncated = true;
+                    return 0;
+                }
+                if (matcher && response.compare(9, 1, "3") != 0)
+                {
+                    fed = std::max(fed, headEnd + 4);
+                    auto body = std::string_view(response).substr(fed, headEnd + 4 + length - fed);
+                    fed += body.size();
+                    if (matcher->feed(body) != BodyMatcher::Verdict::Pending)
+                    {
+                        decided = true;
+                        break;
+                    }
+                }
+                if (method == "HEAD" || response.size() >= headEnd + 4 + length)
+                    break;
+            }
+            ::close(fd);
+            if (decided)
+                return std::atoi(response.c_str() + 9);
+
+            auto headEnd = response.find("\r\n\r\n");
+            if (headEnd == std::string::npos || !response.starts_with("HTTP/1.1 "))
+                return 0;
+            size_t length = 0;
+            if (auto cl = response.find("Content-Length: "); cl != std::string::npos && cl < headEnd)
+                length = std::strtoul(response.c_str() + cl + 16, nullptr, 10);
+            if (method != "HEAD" && response.size() < headEnd + 4 + length)
+                return 0; // body never finished
+            int code = std::atoi(response.c_str() + 9);
+            if (code / 100 != 3)
+                return code;
+
+            auto location = response.find("Location: ");
+            if (location == std::string::npos || location > headEnd)
+                return code;
+            auto end = response.find("\r\n", location);
+            url = "http://" + std::string(parsed->authority) + response.substr(location + 10, end - location - 10);
+        }
+        return 0;
+    }
+
+    // One round of probes through a private executor. Requests run on
+    // worker threads; completions are handed back to this thread, which
+    // plays the part of the game's main thread.
+    struct Round
+    {
+        LatencyHistogram latency;
+        std::vector<int> codes;
+        // answers whose body failed the request's assertions
+        size_t mismatches = 0;
+        // answers cut off at the body cap
+        size_t truncated = 0;
+        Clock::duration wall{};
+    };
+
+    Round runRound(std::vector<ProbeRequest> const &requests, ms timeout)
+    {
+        ProbeExecutor executor;
+        std::mutex mutex;
+        std::vector<std::function<void()>> completions;
+        std::vector<std::thread> workers;
+        Round round;
+        size_t done = 0;
+
+        auto start = Clock::now();
+        for (auto const &request : requests)
+        {
+            executor.submit(probeHost(request.url), request.priority, [&, request](ProbeExecutor::Done finished) {
+                workers.emplace_back([&, request, finished] {
+                    auto sent = Clock::now();
+                    BodyMatcher matcher(request.expect, request.bodyCap > 0 ? request.bodyCap : SIZE_MAX);
+                    bool truncated = false;
+                    int code = fetch(request.url, probeMethod(request), timeout,
+                                     request.expect.empty() ? nullptr : &matcher,
+                                     request.mode == ProbeMode::Capped ? request.bodyCap : 0, &truncated);
+                    bool mismatch = code / 100 == 2 && matcher.finish() != BodyMatcher::Verdict::Pass;
+                    auto latency = Clock::now() - sent;
+                    std::lock_guard lock(mutex);
+                    completions.push_back([&, code, mismatch, truncated, latency, finished] {
+                        round.codes.push_back(code);
+                        round.mismatches += mismatch;
+                        round.truncated += truncated;
+                        round.latency.record(latency);
+                        ++done;
+                        finished();
+                    });
+                });
+            });
+        }
+
+        while (done < requests.size())
+        {
+            std::vector<std::function<void()>> ready;
+            {
+                std::lock_guard lock(mutex);
+                ready.swap(completions);
+            }
+            for (auto &completion : ready)
+                completion();
+            if (ready.empty())
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        round.wall = Clock::now() - start;
+        for (auto &worker : workers)
+            worker.join();
+        return round;
+    }
+
+    ProbeRequest target(std::string const &query, ProbePriority priority, ProbeMode mode = ProbeMode::NoBody)
+    {
+        ProbeRequest req;
+        req.url = server().url("/?" + query);
+        req.priority = priority;
+        req.mode = mode;
+        return req;
+    }
+
+    void report(benchmark::State &state, LatencyHistogram const &latency, size_t probes)
+    {
+        auto summary = latency.summary();
+        state.counters["p50_ms"] = summary.p50.count() / 1000.0;
+        state.counters["p99_ms"] = summary.p99.count() / 1000.0;
+        state.counters["probes"] = benchmark::Counter(static_cast<double>(probes), benchmark::Counter::kIsRate);
+    }
+
+    // StatusMonitor: the four built-ins, one HEAD and three header-only checks
+    void BM_ProbeBuiltins(benchmark::State &state)
+    {
+        std::vector<ProbeRequest> requests{
+            target("latency=5", ProbePriority::High, ProbeMode::Head),
+            target("latency=5&body=4096", ProbePriority::High),
+            target("latency=5&body=512", ProbePriority::High),
+            target("latency=5", ProbePriority::High),
+        };
+        LatencyHistogram latency;
+        size_t probes = 0;
+        for (auto _ : state)
+        {
+            auto round = runRound(requests, ms(1000));
+            for (int code : round.codes)
+            {
+                if (code != 200)
+                    state.SkipWithError("built-in probe failed against a healthy server");
+            }
+            latency.record(round.latency.max());
+            probes += requests.size();
+        }
+        if (latency.percentile(99) > ms(100))
+            state.SkipWithError("built-in probe p99 over 100ms for a 5ms server");
+        report(state, latency, probes);
+    }
+
+    // StatusNode: many custom endpoints on one host, with a log-normal
+    // latency, 5xx flapping and the odd reset
+    void BM_ProbeCustom(benchmark::State &state)
+    {
+        std::vector<ProbeRequest> requests;
+        for (int64_t i = 0; i < state.range(0); ++i)
+            requests.push_back(target("latency=ln:10:0.5&flap=0.2&reset=0.05&i=" + std::to_string(i), ProbePriority::Normal));
+
+        LatencyHistogram latency;
+        size_t probes = 0;
+        for (auto _ : state)
+        {
+            auto round = runRound(requests, ms(2000));
+            if (round.codes.size() != requests.size())
+                state.SkipWithError("custom probes went missing");
+            for (int code : round.codes)
+            {
+                if (code != 200 && code != 503 && code != 0)
+                    state.SkipWithError("unexpected status from the fault server");
+            }
+            probes += requests.size();
+            // p99 of one probe, queue wait excluded
+            latency.record(round.latency.percentile(99));
+        }
+        if (latency.percentile(99) > ms(500))
+            state.SkipWithError("custom probe p99 over 500ms for a ~10ms server");
+        report(state, latency, probes);
+    }
+
+    // A server that sends half a body and stalls must be cut off by the
+    // probe timeout, not hang the pipeline
+    void BM_ProbeStalledBody(benchmark::State &state)
+    {
+        std::vector<ProbeRequest> requests{target("stall=3000&body=1024", ProbePriority::Normal, ProbeMode::Full)};
+        LatencyHistogram latency;
+        for (auto _ : state)
+        {
+            auto round = runRound(requests, ms(150));
+            if (round.codes.front() != 0)
+                state.SkipWithError("stalled body was reported as a response");
+            latency.record(round.latency.max());
+        }
+        if (latency.max() > ms(400))
+            state.SkipWithError("stalled probe outlived its 150ms timeout");
+        report(state, latency, state.iterations());
+    }
+
+    // A body check must stop reading once it has its answer: the marker is
+    // in the first chunk, the server stalls after half the body
+    void BM_ProbeContentEarlyExit(benchmark::State &state)
+    {
+        auto request = target("stall=3000&body=65536&mark=level-data&at=64", ProbePriority::High, ProbeMode::Full);
+        request.expect = {{BodyAssertion::Kind::Contains, "level-data"}};
+        request.bodyCap = 16384;
+        std::vector<ProbeRequest> requests{request};
+        LatencyHistogram latency;
+        for (auto _ : state)
+        {
+            auto round = runRound(requests, ms(1000));
+            if (round.codes.front() != 200 || round.mismatches != 0)
+                state.SkipWithError("body check missed the marker");
+            latency.record(round.latency.max());
+        }
+        if (latency.max() > ms(150))
+            state.SkipWithError("body check kept reading after its verdict");
+        report(state, latency, state.iterations());
+    }
+
+    // A 200 whose body is an error page must not count as up
+    void BM_ProbeContentMismatch(benchmark::State &state)
+    {
+        auto request = target("body=8192&mark=error-page&at=6000", ProbePriority::High, ProbeMode::Full);
+        request.expect = {{BodyAssertion::Kind::Excludes, "error-page"}};
+        request.bodyCap = 16384;
+        std::vector<ProbeRequest> requests{request};
+        LatencyHistogram latency;
+        for (auto _ : state)
+        {
+            auto round = runRound(requests, ms(1000));
+            if (round.codes.front() != 200 || round.mismatches != 1)
+                state.SkipWithError("error page passed the body check");
+            latency.record(round.latency.max());
+        }
+        report(state, latency, state.iterations());
+    }
+
+    // Capped probe against a server that ignores Range and sends 1 MB
+    // slowly: the client has to stop at the cap instead of taking it all
+    void BM_ProbeCappedIgnoredRange(benchmark::State &state)
+    {
+        auto request = target("body=1048576&stall=3000", ProbePriority::Normal, ProbeMode::Capped);
+        request.bodyCap = 4096;
+        std::vector<ProbeRequest> requests{request};
+        LatencyHistogram latency;
+        for (auto _ : state)
+        {
+            auto round = runRound(requests, ms(1000));
+            if (round.truncated != 1)
+                state.SkipWithError("oversized body was not cut off at the cap");
+            latency.record(round.latency.max());
+        }
+        if (latency.max() > ms(150))
+            state.SkipWithError("capped probe kept reading past its cap");
+        report(state, latency, state.iterations());
+    }
+
+    // Offline device: the internet check fails and every remote target
+    // would wait out its timeout. With the dependency graph (arg 1) they are
+    // skipped as soon as the internet check reports.
+    void BM_ProbeUpstreamDown(benchmark::State &state)
+    {
+        bool useGraph = state.range(0) != 0;
+        std::vector<ProbeRequest> internet{target("reset=1", ProbePriority::High, ProbeMode::Head)};
+        std::vector<std::pair<std::string, ProbeRequest>> remote;
+        for (auto name : {"boomlings", "geode", "argon"})
+            remote.emplace_back(name, target(std::string("stall=3000&s=") + name, ProbePriority::High));
+        for (int i = 0; i < 16; ++i)
+            remote.emplace_back("custom:" + std::to_string(i), target("stall=3000&i=" + std::to_string(i), ProbePriority::Normal));
+
+        ProbeDependencies deps;
+        for (auto const &[name, request] : remote)
+            deps.depend(name, "internet");
+
+        LatencyHistogram latency;
+        size_t sent = 0;
+        for (auto _ : state)
+        {
+            auto started = Clock::now();
+            auto round = runRound(internet, ms(300));
+            if (round.codes.front() != 0)
+                state.SkipWithError("reset internet target answered");
+            deps.report("internet", false);
+
+            std::vector<ProbeRequest> requests;
+            for (auto const &[name, request] : remote)
+            {
+                if (!useGraph || !deps.skip(name))
+                    requests.push_back(request);
+            }
+            if (!requests.empty())
+                runRound(requests, ms(300));
+            sent += requests.size();
+            latency.record(Clock::now() - started);
+            // recovers between rounds so the next one starts clean
+            deps.report("internet", true);
+        }
+        if (useGraph && sent != 0)
+            state.SkipWithError("dependents were probed while the internet was down");
+        state.counters["remote_requests"] = benchmark::Counter(static_cast<double>(sent), benchmark::Counter::kAvgIterations);
+        report(state, latency, state.iterations());
+    }
+
+    void BM_ProbeRedirectChain(benchmark::State &state)
+    {
+        std::vector<ProbeRequest> requests{target("redirect=3&latency=1", ProbePriority::Normal, ProbeMode::Full)};
+        LatencyHistogram latency;
+        auto before = server().stats().redirects.load();
+        for (auto _ : state)
+        {
+            auto round = runRound(requests, ms(1000));
+            if (round.codes.front() != 200)
+                state.SkipWithError("redirect chain did not end in a 200");
+            latency.record(round.latency.max());
+        }
+        if (server().stats().redirects.load() - before != 3 * static_cast<uint64_t>(state.iterations()))
+            state.SkipWithError("expected three redirects per probe");
+        report(state, latency, state.iterations());
+    }
+}
+
+BENCHMARK(BM_ProbeBuiltins)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_ProbeCustom)->Arg(16)->Arg(64)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_ProbeStalledBody)->Unit(benchmark::kMillisecond)->UseRealTime()->Iterations(5);
+BENCHMARK(BM_ProbeContentEarlyExit)->Unit(benchmark::kMillisecond)->UseRealTime()->Iterations(5);
+BENCHMARK(BM_ProbeContentMismatch)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_ProbeCappedIgnoredRange)->Unit(benchmark::kMillisecond)->UseRealTime()->Iterations(5);
+BENCHMARK(BM_ProbeUpstreamDown)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime()->Iterations(3);
+BENCHMARK(BM_ProbeRedirectChain)->Unit(benchmark::kMillisecond)->UseRealTime();
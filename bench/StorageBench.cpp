@@ -0,0 +1,159 @@
+// Storage and aggregation benchmarks at 10, 1k and 10k custom nodes.
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "IoWorker.hpp"
+#include "StatusAggregate.hpp"
+#include "StatusStorage.hpp"
+
+namespace
+{
+    std::filesystem::path freshDirectory(std::string const &name)
+    {
+        auto dir = std::filesystem::temp_directory_path() / "servers-status-bench" / name;
+        std::filesystem::remove_all(dir);
+        std::filesystem::create_directories(dir);
+        return dir;
+    }
+
+    StoredNode makeNode(size_t i)
+    {
+        return StoredNode{
+            "node-" + std::to_string(i),
+            "Server " + std::to_string(i),
+            "https://status" + std::to_string(i) + ".example.org/health",
+            i % 7 != 0,
+            EpochTime{1700000000 + static_cast<int64_t>(i)},
+        };
+    }
+
+    void fill(size_t count)
+    {
+        for (size_t i = 0; i < count; ++i)
+            StatusStorage::upsertNode(makeNode(i));
+    }
+
+    void BM_Upsert(benchmark::State &state)
+    {
+        auto count = static_cast<size_t>(state.range(0));
+        auto dir = freshDirectory("upsert");
+        for (auto _ : state)
+        {
+            state.PauseTiming();
+            StatusStorage::setDirectory(dir);
+            std::filesystem::remove_all(dir);
+            std::filesystem::create_directories(dir);
+            state.ResumeTiming();
+            fill(count);
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    void BM_Save(benchmark::State &state)
+    {
+        auto count = static_cast<size_t>(state.range(0));
+        StatusStorage::setDirectory(freshDirectory("save"));
+        fill(count);
+        auto node = makeNode(0);
+        for (auto _ : state)
+        {
+            // a definition change forces a full snapshot
+            node.name += '.';
+            StatusStorage::upsertNode(node);
+            StatusStorage::flush(true);
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    void BM_Load(benchmark::State &state)
+    {
+        auto count = static_cast<size_t>(state.range(0));
+        auto dir = freshDirectory("load");
+        StatusStorage::setDirectory(dir);
+        fill(count);
+        StatusStorage::flush(true);
+        for (auto _ : state)
+        {
+            // switching directories drops the store, the access reloads it
+            StatusStorage::setDirectory(dir);
+            benchmark::DoNotOptimize(StatusStorage::nodes().size());
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    void BM_SetState(benchmark::State &state)
+    {
+        auto count = static_cast<size_t>(state.range(0));
+        StatusStorage::setDirectory(freshDirectory("state"));
+        fill(count);
+        StatusStorage::flush(true);
+        std::vector<NodeHandle> handles;
+        for (size_t i = 0; i < count; ++i)
+            handles.push_back(StatusStorage::find("node-" + std::to_string(i)));
+
+        int64_t now = 1800000000;
+        size_t next = 0;
+        for (auto _ : state)
+        {
+            auto handle = handles[next++ % handles.size()];
+            benchmark::DoNotOptimize(StatusStorage::setState(handle, now % 3 != 0, EpochTime{now}));
+            ++now;
+        }
+        StatusStorage::flush(true);
+    }
+
+    // Main-thread cost of one monitor tick that saw range(0) state changes:
+    // the writes themselves happen on the I/O worker
+    void BM_Tick(benchmark::State &state)
+    {
+        auto changes = static_cast<size_t>(state.range(0));
+        StatusStorage::setDirectory(freshDirectory("tick"));
+        fill(1000);
+        StatusStorage::flush(true);
+        std::vector<NodeHandle> handles;
+        for (size_t i = 0; i < 1000; ++i)
+            handles.push_back(StatusStorage::find("node-" + std::to_string(i)));
+
+        auto worker = IoWorker::get();
+        auto before = worker->stats();
+        int64_t now = 1800000000;
+        size_t next = 0;
+        for (auto _ : state)
+        {
+            for (size_t i = 0; i < changes; ++i, ++now)
+                StatusStorage::setState(handles[next++ % handles.size()], now % 3 != 0, EpochTime{now});
+            worker->poll();
+            StatusStorage::flush();
+        }
+        StatusStorage::flush(true);
+        auto after = worker->stats();
+        using us = std::chrono::duration<double, std::micro>;
+        state.counters["io_jobs"] = static_cast<double>(after.completed - before.completed);
+        state.counters["coalesced"] = static_cast<double>(after.coalesced - before.coalesced);
+        state.counters["worker_us"] = us(after.busy - before.busy).count();
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    void BM_Aggregate(benchmark::State &state)
+    {
+        auto count = static_cast<size_t>(state.range(0));
+        StatusStorage::setDirectory(freshDirectory("aggregate"));
+        fill(count);
+        for (auto _ : state)
+        {
+            bool const up[] = {StatusStorage::allOnline(), true, true, false, true};
+            benchmark::DoNotOptimize(aggregateStatus(up));
+        }
+    }
+}
+
+BENCHMARK(BM_Upsert)->Arg(10)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Save)->Arg(10)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_Load)->Arg(10)->Arg(1000)->Arg(10000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_SetState)->Arg(10)->Arg(1000)->Arg(10000);
+BENCHMARK(BM_Tick)->Arg(1)->Arg(64)->Arg(1024);
+BENCHMARK(BM_Aggregate)->Arg(10)->Arg(1000)->Arg(10000);
@@ -0,0 +1,89 @@
+// UrlParser::isValid against the std::regex it replaced, over a mixed corpus
+// of real, random and malformed URLs. Refuses to report a time if the two
+// ever disagree on a URL.
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "UrlParser.hpp"
+
+namespace
+{
+    std::regex const &urlRegex()
+    {
+        static std::regex const re(R"((http|https):\/\/([\w_-]+(?:(?:\.[\w_-]+)+))([\w.,@?^=%&:\/~+#-]*[\w@?^=%&\/~+#-]))");
+        return re;
+    }
+
+    std::vector<std::string> const &corpus()
+    {
+        static auto const urls = [] {
+            static char const *const fixed[] = {
+                "https://www.google.com",
+                "https://www.boomlings.com/database/getGJLevels21.php",
+                "https://api.geode-sdk.org/v1/mods?gd=2.2074&page=1",
+                "https://argon.globed.dev/v1/status",
+                "http://example.com:8080/health?verbose=1#top",
+                "https://localhost/",
+                "https://a.b",
+                "ftp://files.example.com/",
+                "https://sub..example.com/path",
+                "https://example.com/trailing.",
+            };
+            static std::string const alphabet = "abcxyz019_-.,@?^=%&:/~+#! ";
+
+            std::vector<std::string> out(std::begin(fixed), std::end(fixed));
+            std::mt19937 rng(12345);
+            while (out.size() < 20000)
+            {
+                std::string url = rng() % 2 ? "https://" : "http://";
+                auto length = 4 + rng() % 40;
+                for (size_t i = 0; i < length; ++i)
+                    url += alphabet[rng() % alphabet.size()];
+                // keep a good share of realistic, valid URLs in the mix
+                if (rng() % 3 == 0)
+                    url = "https://status" + std::to_string(rng() % 1000) + ".example.org/api/v" + std::to_string(rng() % 3);
+                out.push_back(std::move(url));
+            }
+            return out;
+        }();
+        return urls;
+    }
+
+    bool agree()
+    {
+        for (auto const &url : corpus())
+        {
+            if (std::regex_match(url, urlRegex()) != UrlParser::isValid(url))
+                return false;
+        }
+        return true;
+    }
+
+    void BM_UrlValidateRegex(benchmark::State &state)
+    {
+        auto const &urls = corpus();
+        size_t next = 0;
+        for (auto _ : state)
+            benchmark::DoNotOptimize(std::regex_match(urls[next++ % urls.size()], urlRegex()));
+    }
+
+    void BM_UrlValidateParser(benchmark::State &state)
+    {
+        if (!agree())
+        {
+            state.SkipWithError("UrlParser and the regex disagree on the corpus");
+            return;
+        }
+        auto const &urls = corpus();
+        size_t next = 0;
+        for (auto _ : state)
+            benchmark::DoNotOptimize(UrlParser::isValid(urls[next++ % urls.size()]));
+    }
+}
+
+BENCHMARK(BM_UrlValidateRegex);
+BENCHMARK(BM_UrlValidateParser);
@@ -0,0 +1,63 @@
+#pragma once
+
+// Public API for other mods. Add "arcticwoof.servers_status" as a dependency
+// (or optional dependency; every call then fails while the mod is missing)
+// and include this header:
+//
+//   auto status = servers_status::getStatus("boomlings");
+//   if (status && status->online) ...
+//
+//   servers_status::onStatusChanged([](std::string const &service, servers_status::Status const &status) {
+//       log::info("{} is now {}", service, status.online ? "up" : "down");
+//   });
+//
+// Services are "internet", "boomlings", "geode" and "argon". Everything runs
+// on the main thread, and no request is ever sent on behalf of a caller:
+// results come from the same checks that drive the status icon.
+
+#include <Geode/loader/Dispatch.hpp>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+#define MY_MOD_ID "arcticwoof.servers_status"
+
+namespace servers_status
+{
+    struct Status
+    {
+        // false until the service was checked once; online then holds the
+        // last session's result, if any
+        bool known = false;
+        bool online = false;
+        // HTTP status of the last check, 0 when there was no response
+        int code = 0;
+        // response time percentiles in milliseconds, 0 before any response
+        int64_t p50Ms = 0;
+        int64_t p90Ms = 0;
+        int64_t p99Ms = 0;
+        // epoch seconds of the last successful check, 0 if never
+        int64_t lastOk = 0;
+        // epoch seconds of the last check
+        int64_t checkedAt = 0;
+    };
+
+    using StatusCallback = std::function<void(std::string const &service, Status const &status)>;
+
+    inline geode::Result<Status> getStatus(std::string service)
+        GEODE_EVENT_EXPORT(&getStatus, (service));
+
+    // Called whenever a service goes up or down; returns a handle for
+    // removeListener
+    inline geode::Result<uint64_t> onStatusChanged(StatusCallback callback)
+        GEODE_EVENT_EXPORT(&onStatusChanged, (callback));
+
+    inline geode::Result<> removeListener(uint64_t handle)
+        GEODE_EVENT_EXPORT(&removeListener, (handle));
+
+    // Check every service as soon as possible
+    inline geode::Result<> refresh()
+        GEODE_EVENT_EXPORT(&refresh, ());
+}
+
+#undef MY_MOD_ID
@@ -0,0 +1,312 @@
+#include "CustomProbes.hpp"
+
+#include <algorithm>
+#include <utility>
+
+#include "ProbeDependencies.hpp"
+#include "ProbeHistory.hpp"
+#include "ProbeTargets.hpp"
+#include "StatusStorage.hpp"
+#include "UrlParser.hpp"
+
+using namespace geode::prelude;
+
+namespace
+{
+    // custom endpoints can be numerous, keep their rings small
+    constexpr uint32_t kHistoryCapacity = 2048;
+    // the URL field reports every keystroke; each one pushes the check back
+    constexpr auto kEditSettle = std::chrono::seconds(1);
+}
+
+CustomProbes *CustomProbes::get()
+{
+    static CustomProbes instance;
+    return &instance;
+}
+
+void CustomProbes::retain(ProbeScheduler::Clock::duration stagger)
+{
+    if (m_retained++ > 0)
+        return;
+    auto scheduler = ProbeScheduler::get();
+    auto delay = ProbeScheduler::Clock::duration::zero();
+    for (auto const &node : StatusStorage::nodes())
+    {
+        auto &state = m_states[node.id];
+        schedule(node.id, state);
+        if (stagger > stagger.zero())
+            scheduler->fireIn(state.probe, delay += stagger);
+        else
+            scheduler->fireSoon(state.probe);
+    }
+}
+
+void CustomProbes::release()
+{
+    if (m_retained == 0 || --m_retained > 0)
+        return;
+    auto scheduler = ProbeScheduler::get();
+    auto deps = ProbeDependencies::get();
+    for (auto &[id, state] : m_states)
+    {
+        scheduler->remove(state.probe);
+        state.probe = {};
+        state.ticket.cancel();
+        state.pending = false;
+        // schedule() adds the node and its edges back from storage
+        deps->remove("custom:" + id);
+    }
+}
+
+void CustomProbes::add(std::string const &id)
+{
+    auto &state = m_states[id];
+    if (m_retained > 0)
+        schedule(id, state);
+    notify(id);
+}
+
+void CustomProbes::remove(std::string const &id)
+{
+    auto it = m_states.find(id);
+    if (it == m_states.end())
+        return;
+    ProbeScheduler::get()->remove(it->second.probe);
+    m_states.erase(it);
+    ProbeDependencies::get()->remove("custom:" + id);
+
+    // endpoints that depended on it go back to the internet check alone
+    std::vector<StoredNode> dependents;
+    for (auto const &node : StatusStorage::nodes())
+    {
+        if (node.depends_on == id)
+            dependents.push_back(node);
+    }
+    for (auto &node : dependents)
+    {
+        node.depends_on.clear();
+        StatusStorage::upsertNode(node);
+        notify(node.id);
+    }
+    notify(id);
+}
+
+void CustomProbes::setInterval(ProbeScheduler::Clock::duration interval)
+{
+    m_interval = interval;
+    auto scheduler = ProbeScheduler::get();
+    for (auto &[id, state] : m_states)
+        scheduler->setInterval(state.probe, interval);
+}
+
+void CustomProbes::setBackoffConfig(ProbeBackoff::Config config)
+{
+    m_backoffConfig = config;
+    for (auto &[id, state] : m_states)
+        state.backoff.setConfig(config);
+}
+
+void CustomProbes::checkAll()
+{
+    auto scheduler = ProbeScheduler::get();
+    for (auto &[id, state] : m_states)
+        scheduler->fireSoon(state.probe);
+}
+
+void CustomProbes::checkStale()
+{
+    auto scheduler = ProbeScheduler::get();
+    for (auto &[id, state] : m_states)
+    {
+        auto node = StatusStorage::get(StatusStorage::find(id));
+        if (node && !ProbeCache::get()->fresh(ProbeTargets::custom(node->url)))
+            scheduler->fireSoon(state.probe);
+    }
+}
+
+bool CustomProbes::setUpstream(std::string const &id, std::string const &upstreamId)
+{
+    auto node = StatusStorage::get(StatusStorage::find(id));
+    if (!node)
+        return false;
+    if (node->depends_on == upstreamId)
+        return true;
+    // each endpoint has at most one custom upstream, so the edge closes a
+    // cycle exactly when the upstream's chain leads back here; the hop
+    // limit only guards against a damaged save
+    auto hops = StatusStorage::nodes().size();
+    for (auto next = upstreamId; !next.empty() && hops > 0; --hops)
+    {
+        if (next == id)
+            return false;
+        auto up = StatusStorage::get(StatusStorage::find(next));
+        next = up ? up->depends_on : std::string();
+    }
+
+    auto updated = *node;
+    auto previous = std::exchange(updated.depends_on, upstreamId);
+    StatusStorage::upsertNode(updated);
+
+    auto it = m_states.find(id);
+    if (it != m_states.end() && ProbeScheduler::get()->contains(it->second.probe))
+    {
+        auto deps = ProbeDependencies::get();
+        if (!previous.empty())
+            deps->undepend("custom:" + id, "custom:" + previous);
+        if (!upstreamId.empty())
+            deps->depend("custom:" + id, "custom:" + upstreamId);
+    }
+    notify(id);
+    return true;
+}
+
+void CustomProbes::urlChanged(std::string const &id)
+{
+    auto it = m_states.find(id);
+    if (it == m_states.end())
+        return;
+    auto &state = it->second;
+    // a result for the old URL must not land on the new one
+    state.ticket.cancel();
+    state.code = 0;
+    state.pending = true;
+    state.manual = false;
+    state.upstream.clear();
+    state.backoff = ProbeBackoff(m_backoffConfig);
+    auto scheduler = ProbeScheduler::get();
+    if (scheduler->contains(state.probe))
+        scheduler->fireIn(state.probe, kEditSettle);
+    else
+        check(id);
+    notify(id);
+}
+
+void CustomProbes::schedule(std::string const &id, State &state)
+{
+    auto scheduler = ProbeScheduler::get();
+    if (scheduler->contains(state.probe))
+        return;
+    state.backoff.setConfig(m_backoffConfig);
+    state.probe = scheduler->add("custom:" + id, m_interval,
+                                 [this, id]() { this->check(id); });
+    auto deps = ProbeDependencies::get();
+    deps->add("custom:" + id, [this, id](std::string const *upstream)
+              { onUpstream(id, upstream); });
+    deps->depend("custom:" + id, "internet");
+    auto node = StatusStorage::get(StatusStorage::find(id));
+    if (node && !node->depends_on.empty() && StatusStorage::find(node->depends_on).valid())
+        deps->depend("custom:" + id, "custom:" + node->depends_on);
+}
+
+void CustomProbes::onUpstream(std::string const &id, std::string const *upstream)
+{
+    auto it = m_states.find(id);
+    if (it == m_states.end())
+        return;
+    auto &state = it->second;
+    if (upstream)
+    {
+        // a manual check still goes through; the user asked for it
+        if (state.pending && state.manual)
+            return;
+        state.upstream = *upstream;
+        state.ticket.cancel();
+        state.pending = false;
+    }
+    else
+    {
+        state.upstream.clear();
+        ProbeScheduler::get()->fireSoon(state.probe);
+    }
+    notify(id);
+}
+
+void CustomProbes::check(std::string const &id, bool manual, Done done)
+{
+    auto handle = StatusStorage::find(id);
+    auto node = StatusStorage::get(handle);
+    // nothing to check yet; the row reports bad URLs while they are typed
+    if (!node || !UrlParser::isValid(node->url))
+    {
+        // urlChanged() marked it pending for a URL that is no longer valid
+        if (auto it = m_states.find(id); it != m_states.end() && it->second.pending)
+        {
+            it->second.ticket.cancel();
+            it->second.pending = false;
+            notify(id);
+        }
+        return;
+    }
+
+    auto &state = m_states[id];
+    // nothing to learn while a target it depends on is down
+    if (!manual)
+    {
+        if (auto upstream = ProbeDependencies::get()->skip("custom:" + id))
+        {
+            state.upstream = *upstream;
+            state.pending = false;
+            notify(id);
+            return;
+        }
+    }
+    state.pending = true;
+    state.manual = manual;
+    notify(id);
+
+    // endpoints with the same URL share one request; never a cached result,
+    // the backoff would count it twice
+    state.ticket = ProbeCache::get()->probe(
+        ProbeTargets::custom(node->url),
+        [this, id, done](ProbeResult const &result) {
+            ProbeHistory::get("custom-" + id, kHistoryCapacity)->record(result);
+            auto it = m_states.find(id);
+            if (it == m_states.end())
+                return;
+            auto &state = it->second;
+            bool ok = result.ok && result.code == 200;
+            state.code = result.code;
+            state.pending = false;
+            state.upstream.clear();
+            if (ProbeScheduler::get()->contains(state.probe))
+                ProbeScheduler::get()->fireIn(state.probe, state.backoff.next(ok));
+
+            auto handle = StatusStorage::find(id);
+            if (auto node = StatusStorage::get(handle))
+                StatusStorage::setState(handle, ok, ok ? EpochTime::now() : node->last_ping);
+            ProbeDependencies::get()->report("custom:" + id, ok);
+
+            if (done)
+                done(result);
+            notify(id);
+        },
+        false);
+}
+
+CustomProbes::State const *CustomProbes::state(std::string const &id) const
+{
+    auto it = m_states.find(id);
+    return it == m_states.end() ? nullptr : &it->second;
+}
+
+uint64_t CustomProbes::listen(Listener listener)
+{
+    auto handle = m_nextListener++;
+    m_listeners.emplace_back(handle, std::move(listener));
+    return handle;
+}
+
+void CustomProbes::unlisten(uint64_t handle)
+{
+    std::erase_if(m_listeners, [handle](auto const &l)
+                  { return l.first == handle; });
+}
+
+void CustomProbes::notify(std::string const &id)
+{
+    // listeners come and go as rows are recycled; work on a copy
+    auto listeners = m_listeners;
+    for (auto const &[handle, listener] : listeners)
+        listener(id);
+}
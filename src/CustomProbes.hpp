@@ -0,0 +1,94 @@
+#pragma once
+
+#include <Geode/Geode.hpp>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ProbeBackoff.hpp"
+#include "ProbeCache.hpp"
+#include "ProbeScheduler.hpp"
+
+// Probe state of the custom endpoints, kept apart from the rows that show
+// it: the custom status list only builds rows for what is on screen and
+// recycles them while scrolling, so a row is just a view bound to an id.
+// Periodic checks run for every stored endpoint while at least one holder
+// has the probes retained; the status monitor holds them for the whole
+// session, so custom endpoints are watched in the background like the
+// built-in servers. Every endpoint depends on the internet check, and may
+// also depend on one other endpoint; it is skipped while either is down.
+// Main thread only.
+class CustomProbes
+{
+public:
+    struct State
+    {
+        // HTTP status of the last check, 0 before any response
+        int code = 0;
+        // a check is in flight
+        bool pending = false;
+        // the check in flight was asked for by the user
+        bool manual = false;
+        // target that is down and keeps this endpoint from being checked
+        std::string upstream;
+        ProbeScheduler::Id probe;
+        ProbeBackoff backoff;
+        ProbeTicket ticket;
+    };
+
+    // Told the id of an endpoint whose state changed
+    using Listener = std::function<void(std::string const &id)>;
+    using Done = std::function<void(ProbeResult const &result)>;
+
+    static CustomProbes *get();
+
+    // Periodic checks for all stored endpoints, reference counted. The
+    // first retain checks every endpoint right away, or one every stagger
+    // when one is given.
+    void retain(ProbeScheduler::Clock::duration stagger = {});
+    void release();
+
+    // Start or stop tracking a stored endpoint (after adding or deleting it)
+    void add(std::string const &id);
+    void remove(std::string const &id);
+
+    // Period and retry policy of the periodic checks
+    void setInterval(ProbeScheduler::Clock::duration interval);
+    void setBackoffConfig(ProbeBackoff::Config config);
+    // Check every scheduled endpoint on the next scheduler tick
+    void checkAll();
+    // Same, skipping endpoints with a result younger than the cache time
+    void checkStale();
+    // Only check an endpoint while another one is up, on top of the
+    // internet check. Saved with the node; an empty upstreamId drops the
+    // edge. Returns false, changing nothing, when it would make a cycle.
+    bool setUpstream(std::string const &id, std::string const &upstreamId);
+
+    // The stored URL of an endpoint changed: drop what was known about the
+    // old one and check the new one once typing has settled
+    void urlChanged(std::string const &id);
+    // Check an endpoint now; a manual check always goes to the network,
+    // and done (if any) runs with its result
+    void check(std::string const &id, bool manual = false, Done done = nullptr);
+
+    // null when the endpoint was never checked or tracked
+    State const *state(std::string const &id) const;
+
+    uint64_t listen(Listener listener);
+    void unlisten(uint64_t handle);
+
+private:
+    void schedule(std::string const &id, State &state);
+    void notify(std::string const &id);
+    // Dependency graph callback of an endpoint
+    void onUpstream(std::string const &id, std::string const *upstream);
+
+    std::unordered_map<std::string, State> m_states;
+    std::vector<std::pair<uint64_t, Listener>> m_listeners;
+    uint64_t m_nextListener = 1;
+    int m_retained = 0;
+    ProbeScheduler::Clock::duration m_interval = std::chrono::seconds(30);
+    ProbeBackoff::Config m_backoffConfig;
+};
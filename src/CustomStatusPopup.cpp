@@ -6,14 +6,25 @@
 #include <Geode/ui/Border.hpp>
 #include <Geode/ui/GeodeUI.hpp>
 #include <algorithm>
+#include <cmath>
 #include <ctime>
 #include <string>
 
+#include "CustomProbes.hpp"
+#include "ProbeHistory.hpp"
 #include "StatusNode.hpp"
 #include "StatusStorage.hpp"
 
 using namespace geode::prelude;
 
+namespace {
+      constexpr float kRowHeight = 90.f;
+      constexpr float kRowGap = 1.f;
+      constexpr float kRowStride = kRowHeight + kRowGap;
+      // rows kept alive past each edge of the viewport
+      constexpr size_t kRowMargin = 1;
+}
+
 CustomStatusPopup* CustomStatusPopup::create() {
       auto ret = new CustomStatusPopup();
       if (ret && ret->init()) {
@@ -50,13 +61,6 @@ bool CustomStatusPopup::init() {
             m_scrollContent->ignoreAnchorPointForPosition(false);
             m_scrollContent->setContentSize({bgScroll->getContentSize().width, bgScroll->getContentSize().height});
             m_scrollContent->setPosition({0.f, 0.f});
-            m_scrollContent->setLayout(ColumnLayout::create()
-                                           ->setGap(1.f)
-                                           ->setAutoGrowAxis(200.f)
-                                           ->setGrowCrossAxis(true)
-                                           ->setCrossAxisOverflow(true)
-                                           ->setAxisReverse(true)
-                                           ->setAxisAlignment(AxisAlignment::End));
       }
 
       auto menu = CCMenu::create();
@@ -72,62 +76,127 @@ bool CustomStatusPopup::init() {
       addButton->setID("custom-status-add-button");
       menu->addChild(addButton);
 
-      // Restore nodes from JSON storage
-      {
-            auto stored = StatusStorage::load();
-            m_nodes.clear();
-            size_t i = 0;
-            for (auto const& s : stored) {
-                  auto name = s.name.empty() ? fmt::format("Custom Status {}", ++i) : s.name;
-                  auto url = s.url;
-                  if (auto node = StatusNode::create(name, url, s.id)) {
-                        node->setOnDelete([this](StatusNode* n) {
-                    // Remove from storage
-                    auto list = StatusStorage::load();
-                    StatusStorage::removeById(list, n->getID());
-                    StatusStorage::save(list);
-                    // Remove from UI
-                    m_nodes.erase(std::remove(m_nodes.begin(), m_nodes.end(), n), m_nodes.end());
-                    if (n->getParent()) n->removeFromParentAndCleanup(true);
-                    refreshLayout(); });
-                        m_scrollContent->addChild(node);
-                        m_nodes.push_back(node);
-                  }
-            }
-      }
+      // Only the ids are kept; rows are made for the visible ones and show
+      // what the monitor's background checks found
+      auto const& stored = StatusStorage::nodes();
+      m_ids.reserve(stored.size());
+      for (auto const& s : stored) m_ids.push_back(s.id);
 
       refreshLayout();
       m_scrollLayer->scrollToTop();
+      updateVisibleRows(true);
+      this->scheduleUpdate();
 
       return true;
 } 
 
+void CustomStatusPopup::update(float) {
+      updateVisibleRows();
+}
+
 void CustomStatusPopup::onAdd(CCObject*) {
-      const auto index = m_nodes.size() + 1;
+      const auto index = m_ids.size() + 1;
       auto name = std::string("") + std::to_string(index);
       auto url = std::string("");
       auto id = fmt::format("status_{}", geode::utils::string::toLower(std::to_string(time(nullptr))) + std::string("_") + std::to_string(index));
 
-      if (auto node = StatusNode::create(name, url, id)) {
-            node->setOnDelete([this](StatusNode* n) {
-            auto list = StatusStorage::load();
-            StatusStorage::removeById(list, n->getID());
-            StatusStorage::save(list);
-            m_nodes.erase(std::remove(m_nodes.begin(), m_nodes.end(), n), m_nodes.end());
-            if (n->getParent()) n->removeFromParentAndCleanup(true);
-            refreshLayout(); });
-            m_scrollContent->addChild(node);
-            m_nodes.push_back(node);
-            // Persist new node
-            auto list = StatusStorage::load();
-            StatusStorage::upsertNode(list, StoredNode{id, name, url, false});
-            StatusStorage::save(list);
-            refreshLayout();
-      }
+      // Persist new node first so the row picks up its storage handle
+      StatusStorage::upsertNode(StoredNode{id, name, url, false});
+      CustomProbes::get()->add(id);
+
+      m_ids.push_back(id);
+      refreshLayout();
+}
+
+void CustomStatusPopup::onDelete(StatusNode* row) {
+      auto id = row->getID();
+      StatusStorage::remove(row->getHandle());
+      ProbeHistory::erase("custom-" + id);
+      CustomProbes::get()->remove(id);
+
+      m_ids.erase(std::remove(m_ids.begin(), m_ids.end(), id), m_ids.end());
+      refreshLayout();
 }
 
 void CustomStatusPopup::refreshLayout() {
       if (!m_scrollLayer || !m_scrollContent)
             return;
-      m_scrollContent->updateLayout();
+
+      // keep the same distance from the top while the content height changes
+      auto viewHeight = m_scrollLayer->getContentSize().height;
+      auto oldHeight = m_scrollContent->getContentSize().height;
+      auto fromTop = m_scrollContent->getPositionY() - (viewHeight - oldHeight);
+
+      auto height = std::max(viewHeight, m_ids.size() * kRowStride);
+      m_scrollContent->setContentSize({m_scrollLayer->getContentSize().width, height});
+      auto y = std::clamp(viewHeight - height + fromTop, viewHeight - height, 0.f);
+      m_scrollContent->setPositionY(y);
+
+      // indices shifted; rebind everything that is on screen
+      updateVisibleRows(true);
+}
+
+Ref<StatusNode> CustomStatusPopup::acquireRow() {
+      if (!m_pool.empty()) {
+            Ref<StatusNode> row = m_pool.back();
+            m_pool.pop_back();
+            return row;
+      }
+      Ref<StatusNode> row = StatusNode::create();
+      if (row) row->setOnDelete([this](StatusNode* n) { this->onDelete(n); });
+      return row;
+}
+
+void CustomStatusPopup::updateVisibleRows(bool force) {
+      if (!m_scrollLayer || !m_scrollContent)
+            return;
+
+      auto scrollY = m_scrollContent->getPositionY();
+      if (!force && scrollY == m_lastScrollY)
+            return;
+      m_lastScrollY = scrollY;
+
+      // the viewport in content coordinates is [-scrollY, -scrollY + viewHeight];
+      // row i spans [height - (i + 1) * stride, height - i * stride]
+      auto viewHeight = m_scrollLayer->getContentSize().height;
+      auto height = m_scrollContent->getContentSize().height;
+      size_t first = 0;
+      size_t last = 0;
+      if (!m_ids.empty()) {
+            auto top = std::max(0.f, height - (viewHeight - scrollY));
+            auto bottom = std::max(0.f, height + scrollY);
+            first = static_cast<size_t>(top / kRowStride);
+            last = static_cast<size_t>(std::ceil(bottom / kRowStride));
+            first = first > kRowMargin ? first - kRowMargin : 0;
+            last = std::min(m_ids.size(), last + kRowMargin);
+            first = std::min(first, last);
+      }
+      if (!force && first == m_first && last == m_last)
+            return;
+
+      // hand rows that left the window back to the pool
+      for (auto it = m_visible.begin(); it != m_visible.end();) {
+            if (force || it->first < first || it->first >= last) {
+                  Ref<StatusNode> row = it->second;
+                  row->removeFromParentAndCleanup(false);
+                  m_pool.push_back(row);
+                  it = m_visible.erase(it);
+            } else {
+                  ++it;
+            }
+      }
+
+      auto x = m_scrollContent->getContentSize().width / 2.f;
+      for (auto i = first; i < last; ++i) {
+            if (m_visible.contains(i)) continue;
+            auto row = acquireRow();
+            if (!row) break;
+            // bind before entering the scene so the row renders only once
+            row->bind(m_ids[i], fmt::format("Custom Status {}", i + 1));
+            row->setPosition({x, height - i * kRowStride - kRowHeight / 2.f});
+            m_scrollContent->addChild(row);
+            m_visible.emplace(i, row.data());
+      }
+      m_first = first;
+      m_last = last;
 }
@@ -2,21 +2,38 @@
 
 #include <Geode/Geode.hpp>
 #include <Geode/ui/ScrollLayer.hpp>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 using namespace geode::prelude;
 
-class StatusNode;
+#include "StatusNode.hpp"
 
+// Only the rows in (or next to) the viewport exist; scrolling rebinds rows
+// that left it to the entries coming in, so the list costs the same with
+// ten endpoints or a thousand.
 class CustomStatusPopup : public Popup {
      protected:
       bool init() override;
+      void update(float dt) override;
       void onAdd(CCObject* sender);
+      void onDelete(StatusNode* row);
       void refreshLayout();
+      void updateVisibleRows(bool force = false);
+      Ref<StatusNode> acquireRow();
 
       ScrollLayer* m_scrollLayer = nullptr;
       CCNode* m_scrollContent = nullptr;
-      std::vector<StatusNode*> m_nodes;
+      // stored endpoint ids in list order
+      std::vector<std::string> m_ids;
+      // list index -> row currently bound to it
+      std::unordered_map<size_t, StatusNode*> m_visible;
+      // detached rows ready to be rebound
+      std::vector<Ref<StatusNode>> m_pool;
+      size_t m_first = 0;
+      size_t m_last = 0;
+      float m_lastScrollY = 0.f;
 
      public:
       static CustomStatusPopup* create();
@@ -0,0 +1,275 @@
+#include "ProbeCache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <memory>
+#include <utility>
+
+#include "ProbeTransport.hpp"
+
+using namespace geode::prelude;
+using namespace geode::utils;
+
+ProbeTicket::ProbeTicket(ProbeTicket &&other) noexcept
+    : m_key(std::move(other.m_key)), m_waiter(std::exchange(other.m_waiter, 0))
+{
+}
+
+ProbeTicket &ProbeTicket::operator=(ProbeTicket &&other) noexcept
+{
+    if (this != &other)
+    {
+        cancel();
+        m_key = std::move(other.m_key);
+        m_waiter = std::exchange(other.m_waiter, 0);
+    }
+    return *this;
+}
+
+void ProbeTicket::cancel()
+{
+    if (m_waiter)
+        ProbeCache::get()->detach(m_key, m_waiter);
+    m_waiter = 0;
+}
+
+ProbeCache *ProbeCache::get()
+{
+    // never destroyed: tickets held by other singletons (StatusMonitor,
+    // CustomProbes) detach from it during static destruction, in whatever
+    // order those run
+    static auto *instance = new ProbeCache();
+    return instance;
+}
+
+std::string ProbeCache::normalizeUrl(std::string_view url)
+{
+    // scheme and host are case-insensitive, the fragment never reaches the
+    // server and an empty path is the same as "/"
+    std::string out;
+    out.reserve(url.size() + 1);
+
+    if (auto hash = url.find('#'); hash != std::string_view::npos)
+        url = url.substr(0, hash);
+
+    auto schemeEnd = url.find("://");
+    if (schemeEnd == std::string_view::npos)
+        return std::string(url);
+    auto scheme = url.substr(0, schemeEnd);
+    auto rest = url.substr(schemeEnd + 3);
+    auto hostEnd = std::min(rest.find_first_of("/?"), rest.size());
+    auto host = rest.substr(0, hostEnd);
+    auto path = rest.substr(hostEnd);
+
+    for (char c : scheme)
+        out += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    out += "://";
+    for (char c : host)
+        out += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+
+    // drop the default port
+    if (out.ends_with(":80") && out.starts_with("http://"))
+        out.resize(out.size() - 3);
+    else if (out.ends_with(":443") && out.starts_with("https://"))
+        out.resize(out.size() - 4);
+
+    if (path.empty() || path.front() != '/')
+        out += '/';
+    out += path;
+    return out;
+}
+
+std::string ProbeCache::keyFor(ProbeRequest const &request)
+{
+    auto key = probeMethod(request) + " " + normalizeUrl(request.url);
+    if (request.mode == ProbeMode::Capped)
+        key += fmt::format(" [{}]", request.bodyCap);
+    for (auto const &assertion : request.expect)
+        key += fmt::format(" {}{}", assertion.kind == BodyAssertion::Kind::Contains ? '+' : '-', assertion.needle);
+    if (!request.body.empty())
+    {
+        key += '\n';
+        key += request.body;
+    }
+    return key;
+}
+
+ProbeTicket ProbeCache::probe(ProbeRequest const &request, Callback callback, bool allowCached)
+{
+    auto key = keyFor(request);
+
+    if (allowCached)
+    {
+        if (auto it = m_results.find(key); it != m_results.end() &&
+                                            std::chrono::steady_clock::now() - it->second.at < m_ttl)
+        {
+            callback(it->second);
+            return {};
+        }
+    }
+
+    auto waiter = m_nextWaiter++;
+    if (auto it = m_flights.find(key); it != m_flights.end())
+    {
+        // someone already asked for this, ride along
+        it->second->waiters.emplace_back(waiter, std::move(callback));
+        return {std::move(key), waiter};
+    }
+
+    auto flight = std::make_unique<Flight>();
+    flight->waiters.emplace_back(waiter, std::move(callback));
+    m_flights.emplace(key, std::move(flight));
+
+    // the executor decides when the request actually goes out
+    ProbeExecutor::get()->submit(
+        probeHost(request.url), request.priority,
+        [key, request](ProbeExecutor::Done done) {
+            auto cache = ProbeCache::get();
+            auto it = cache->m_flights.find(key);
+            // dropped while queued, or a later flight for the same key was
+            // already sent by an earlier job
+            if (it == cache->m_flights.end() || it->second->sent)
+            {
+                done();
+                return;
+            }
+
+            auto req = web::WebRequest();
+            req.followRedirects(request.followRedirects);
+            switch (request.mode)
+            {
+            case ProbeMode::Full:
+                break;
+            case ProbeMode::Head:
+            case ProbeMode::NoBody:
+                req.transferBody(false);
+                break;
+            case ProbeMode::Capped:
+                if (request.bodyCap > 0)
+                    req.header("Range", fmt::format("bytes=0-{}", request.bodyCap - 1));
+                break;
+            }
+            bool capped = request.mode == ProbeMode::Capped && request.bodyCap > 0;
+            if (request.timeout.count() > 0)
+                req.timeout(request.timeout);
+            if (!request.body.empty())
+                req.bodyString(request.body);
+
+            auto transport = ProbeTransport::get();
+            transport->configure(req, request);
+            auto host = std::string(probeHost(request.url));
+            bool likelyReused = transport->begin(host);
+
+            auto sent = std::chrono::steady_clock::now();
+            // the response and the cap cut-off race; whichever reaches the
+            // main thread first finishes the flight
+            auto settled = std::make_shared<bool>(false);
+            auto finish = [key, done, host, settled](ProbeResult const &result) {
+                if (std::exchange(*settled, true))
+                    return;
+                ProbeTransport::get()->end(host, result.likelyReused, result.code, result.latency);
+                done();
+                // drops the flight, which cancels a request still running
+                ProbeCache::get()->complete(key, result);
+            };
+            if (capped)
+            {
+                // Range is only a request: a server that ignores it is cut
+                // off as soon as it sends more than the cap
+                auto overflow = std::make_shared<std::atomic<bool>>(false);
+                req.onProgress([finish, overflow, sent, likelyReused, cap = request.bodyCap](web::WebProgress const &progress) {
+                    if (progress.downloaded() <= cap || overflow->exchange(true))
+                        return;
+                    queueInMainThread([finish, sent, likelyReused, bytes = progress.downloaded()]() {
+                        auto now = std::chrono::steady_clock::now();
+                        ProbeResult result{false, 0, now, now - sent, bytes, likelyReused};
+                        result.truncated = true;
+                        finish(result);
+                    });
+                });
+            }
+
+            it->second->sent = true;
+            it->second->task.spawn(
+                req.send(probeMethod(request), request.url),
+                [finish, sent, likelyReused, capped, expect = request.expect,
+                 cap = request.bodyCap](web::WebResponse response) {
+                    auto now = std::chrono::steady_clock::now();
+                    auto const &data = response.data();
+                    // never more than the cap, even when all of it arrived
+                    // before the cut-off could stop the transfer
+                    auto body = std::string_view(reinterpret_cast<char const *>(data.data()), data.size());
+                    if (capped)
+                        body = body.substr(0, cap);
+                    ProbeResult result{response.ok(), response.code(), now, now - sent, body.size(), likelyReused};
+                    if (result.ok && !expect.empty())
+                    {
+                        BodyMatcher matcher(expect, cap > 0 ? cap : body.size());
+                        matcher.feed(body);
+                        result.contentMismatch = matcher.finish() != BodyMatcher::Verdict::Pass;
+                        result.ok = !result.contentMismatch;
+                    }
+                    queueInMainThread([finish, result]() { finish(result); });
+                });
+        });
+    return {std::move(key), waiter};
+}
+
+std::optional<ProbeResult> ProbeCache::peek(ProbeRequest const &request) const
+{
+    auto it = m_results.find(keyFor(request));
+    if (it == m_results.end())
+        return std::nullopt;
+    return it->second;
+}
+
+bool ProbeCache::fresh(ProbeRequest const &request) const
+{
+    auto it = m_results.find(keyFor(request));
+    return it != m_results.end() && std::chrono::steady_clock::now() - it->second.at < m_ttl;
+}
+
+bool ProbeCache::inFlight(ProbeRequest const &request) const
+{
+    return m_flights.contains(keyFor(request));
+}
+
+LatencyHistogram const *ProbeCache::latency(ProbeRequest const &request) const
+{
+    auto it = m_latency.find(keyFor(request));
+    return it == m_latency.end() ? nullptr : &it->second;
+}
+
+void ProbeCache::detach(std::string const &key, uint64_t waiter)
+{
+    auto it = m_flights.find(key);
+    if (it == m_flights.end())
+        return;
+    auto &waiters = it->second->waiters;
+    waiters.erase(std::remove_if(waiters.begin(), waiters.end(), [&](auto const &w)
+                                 { return w.first == waiter; }),
+                  waiters.end());
+    // the executor job finds no flight and hands its slot straight back
+    if (waiters.empty() && !it->second->sent)
+        m_flights.erase(it);
+}
+
+void ProbeCache::complete(std::string const &key, ProbeResult result)
+{
+    m_results[key] = result;
+    ++m_stats.completed;
+    m_stats.bytes += result.bytes;
+    // connection failures and timeouts say nothing about the server
+    if (result.code > 0)
+        m_latency[key].record(result.latency);
+
+    auto it = m_flights.find(key);
+    if (it == m_flights.end())
+        return;
+    // take the flight out first: callbacks may immediately start a new probe
+    auto flight = std::move(it->second);
+    m_flights.erase(it);
+    for (auto &[id, callback] : flight->waiters)
+        callback(result);
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <Geode/Geode.hpp>
+#include <Geode/utils/async.hpp>
+#include <Geode/utils/web.hpp>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "LatencyHistogram.hpp"
+#include "Probe.hpp"
+
+class ProbeCache;
+
+// Keeps a caller attached to a probe. Destroying or cancelling the ticket
+// detaches the callback; a request that is already out keeps running for
+// the others (and the cache), one still queued is dropped with its last
+// waiter.
+class ProbeTicket
+{
+    friend class ProbeCache;
+    std::string m_key;
+    uint64_t m_waiter = 0;
+
+    ProbeTicket(std::string key, uint64_t waiter) : m_key(std::move(key)), m_waiter(waiter) {}
+
+public:
+    ProbeTicket() = default;
+    ProbeTicket(ProbeTicket const &) = delete;
+    ProbeTicket &operator=(ProbeTicket const &) = delete;
+    ProbeTicket(ProbeTicket &&other) noexcept;
+    ProbeTicket &operator=(ProbeTicket &&other) noexcept;
+    ~ProbeTicket() { cancel(); }
+
+    void cancel();
+};
+
+// Process-wide probe result cache with single-flight request coalescing.
+// Results are keyed by method + normalized URL (+ body); concurrent callers
+// for the same key share one outstanding request, and a result younger than
+// the TTL is handed out without touching the network at all.
+class ProbeCache
+{
+public:
+    using Callback = std::function<void(ProbeResult const &)>;
+
+    struct Stats
+    {
+        // requests that went out to the network
+        uint64_t completed = 0;
+        // response body bytes downloaded by them
+        uint64_t bytes = 0;
+    };
+
+    static ProbeCache *get();
+
+    static std::string normalizeUrl(std::string_view url);
+    static std::string keyFor(ProbeRequest const &request);
+
+    // Deliver a result for the request: synchronously if a fresh one is
+    // cached (and allowCached is set), otherwise when the shared request
+    // finishes. Callbacks always run on the main thread.
+    [[nodiscard]] ProbeTicket probe(ProbeRequest const &request, Callback callback, bool allowCached = true);
+    // Last known result, however old (for stale-while-revalidate rendering)
+    std::optional<ProbeResult> peek(ProbeRequest const &request) const;
+    // A result younger than the TTL exists
+    bool fresh(ProbeRequest const &request) const;
+    bool inFlight(ProbeRequest const &request) const;
+    // Latency of every answered request for this probe, or null before the
+    // first response
+    LatencyHistogram const *latency(ProbeRequest const &request) const;
+
+    void setTtl(std::chrono::steady_clock::duration ttl) { m_ttl = ttl; }
+    Stats const &stats() const { return m_stats; }
+
+private:
+    friend class ProbeTicket;
+
+    struct Flight
+    {
+        std::vector<std::pair<uint64_t, Callback>> waiters;
+        geode::async::TaskHolder<geode::utils::web::WebResponse> task;
+        // the request went out; until then nobody waiting means nobody
+        // needs it
+        bool sent = false;
+    };
+
+    void detach(std::string const &key, uint64_t waiter);
+    void complete(std::string const &key, ProbeResult result);
+
+    std::unordered_map<std::string, ProbeResult> m_results;
+    std::unordered_map<std::string, LatencyHistogram> m_latency;
+    std::unordered_map<std::string, std::unique_ptr<Flight>> m_flights;
+    std::chrono::steady_clock::duration m_ttl = std::chrono::seconds(15);
+    uint64_t m_nextWaiter = 1;
+    Stats m_stats;
+};
@@ -0,0 +1,274 @@
+#include "ProbeHistory.hpp"
+
+#include <Geode/Geode.hpp>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <unordered_map>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace geode::prelude;
+
+namespace
+{
+    constexpr uint32_t kMagic = 0x48505353; // "SSPH"
+    // 2 appended the uptime buckets after the ring
+    constexpr uint32_t kVersion = 2;
+
+    constexpr int64_t kMinuteMillis = 60ll * 1000;
+    constexpr int64_t kHourMillis = 60 * kMinuteMillis;
+
+    int64_t epochMillis()
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::system_clock::now().time_since_epoch())
+            .count();
+    }
+
+    std::unordered_map<std::string, std::unique_ptr<ProbeHistory>> &histories()
+    {
+        static std::unordered_map<std::string, std::unique_ptr<ProbeHistory>> map;
+        return map;
+    }
+
+    std::filesystem::path historyPath(std::string const &service)
+    {
+        // custom ids are user data, keep the file name tame
+        std::string name;
+        for (char c : service)
+            name += std::isalnum(static_cast<unsigned char>(c)) || c == '-' ? c : '_';
+        return Mod::get()->getSaveDir() / "history" / (name + ".ring");
+    }
+}
+
+struct ProbeHistory::Header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t recordSize;
+    // total samples ever written; the next one goes to head % capacity
+    uint64_t head;
+    // epoch milliseconds of the first sample, 0 while empty
+    int64_t since;
+};
+
+ProbeHistory *ProbeHistory::get(std::string const &service, uint32_t capacity)
+{
+    auto &map = histories();
+    auto it = map.find(service);
+    if (it == map.end())
+        it = map.emplace(service, std::make_unique<ProbeHistory>(historyPath(service), capacity)).first;
+    return it->second.get();
+}
+
+void ProbeHistory::erase(std::string const &service)
+{
+    histories().erase(service);
+    std::error_code ec;
+    std::filesystem::remove(historyPath(service), ec);
+}
+
+ProbeHistory::ProbeHistory(std::filesystem::path path, uint32_t capacity)
+    : m_path(std::move(path)), m_capacity(std::max<uint32_t>(capacity, 1))
+{
+    if (!map())
+    {
+        // keep working for this session even if the file cannot be mapped
+        log::error("Failed to map {}, probe history will not persist", m_path.string());
+        m_mappedSize = fileSize();
+        m_header = reinterpret_cast<Header *>(new uint64_t[(m_mappedSize + 7) / 8]());
+        m_samples = reinterpret_cast<Sample *>(m_header + 1);
+        m_buckets = reinterpret_cast<Bucket *>(m_samples + m_capacity);
+    }
+
+    auto &header = *m_header;
+    if (header.magic != kMagic || header.capacity != m_capacity ||
+        header.recordSize != sizeof(Sample) || header.version > kVersion)
+    {
+        std::memset(static_cast<void *>(m_header), 0, m_mappedSize);
+        header.magic = kMagic;
+        header.version = kVersion;
+        header.capacity = m_capacity;
+        header.recordSize = sizeof(Sample);
+    }
+    else if (header.version < kVersion)
+    {
+        // a version 1 ring is still valid; the file just grew zeroed
+        // buckets, so count what the ring remembers into them once
+        auto head = header.head;
+        auto first = head > m_capacity ? head - m_capacity : 0;
+        for (auto seq = first; seq < head; ++seq)
+            count(at(seq).time, at(seq).ok);
+        header.since = head > 0 ? at(first).time : 0;
+        header.version = kVersion;
+    }
+}
+
+ProbeHistory::~ProbeHistory()
+{
+    unmap();
+}
+
+size_t ProbeHistory::fileSize() const
+{
+    return sizeof(Header) + sizeof(Sample) * static_cast<size_t>(m_capacity) +
+           sizeof(Bucket) * (kMinuteBuckets + kHourBuckets);
+}
+
+bool ProbeHistory::map()
+{
+    std::error_code ec;
+    std::filesystem::create_directories(m_path.parent_path(), ec);
+    auto size = fileSize();
+
+#ifdef _WIN32
+    auto file = CreateFileW(m_path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                            OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+    LARGE_INTEGER length;
+    length.QuadPart = static_cast<LONGLONG>(size);
+    if (!SetFilePointerEx(file, length, nullptr, FILE_BEGIN) || !SetEndOfFile(file))
+    {
+        CloseHandle(file);
+        return false;
+    }
+    auto mapping = CreateFileMappingW(file, nullptr, PAGE_READWRITE, 0, 0, nullptr);
+    // the mapping keeps the file open
+    CloseHandle(file);
+    if (!mapping)
+        return false;
+    auto view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+    m_mapping = mapping;
+#else
+    int fd = ::open(m_path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        return false;
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+    {
+        ::close(fd);
+        return false;
+    }
+    auto view = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    // the mapping keeps the file open
+    ::close(fd);
+    if (view == MAP_FAILED)
+        return false;
+    m_mapping = view;
+#endif
+
+    m_mappedSize = size;
+    m_header = static_cast<Header *>(view);
+    m_samples = reinterpret_cast<Sample *>(m_header + 1);
+    m_buckets = reinterpret_cast<Bucket *>(m_samples + m_capacity);
+    return true;
+}
+
+void ProbeHistory::unmap()
+{
+    if (!m_header)
+        return;
+    if (!m_mapping)
+    {
+        delete[] reinterpret_cast<uint64_t *>(m_header);
+    }
+    else
+    {
+#ifdef _WIN32
+        UnmapViewOfFile(m_header);
+        CloseHandle(static_cast<HANDLE>(m_mapping));
+#else
+        ::munmap(m_header, m_mappedSize);
+#endif
+    }
+    m_header = nullptr;
+    m_samples = nullptr;
+    m_buckets = nullptr;
+    m_mapping = nullptr;
+}
+
+ProbeHistory::Sample const &ProbeHistory::at(uint64_t seq) const
+{
+    return m_samples[seq % m_capacity];
+}
+
+void ProbeHistory::count(int64_t time, bool ok)
+{
+    auto add = [&](Bucket *buckets, uint32_t slots, int64_t width) {
+        auto index = time / width;
+        auto &bucket = buckets[index % slots];
+        // the slot last held a minute/hour one full lap ago
+        if (bucket.index != index)
+            bucket = {index, 0, 0};
+        ++bucket.total;
+        bucket.up += ok ? 1 : 0;
+    };
+    add(m_buckets, kMinuteBuckets, kMinuteMillis);
+    add(m_buckets + kMinuteBuckets, kHourBuckets, kHourMillis);
+}
+
+void ProbeHistory::record(ProbeResult const &result)
+{
+    if (result.at == m_lastResult)
+        return;
+    m_lastResult = result.at;
+
+    auto now = epochMillis();
+    auto seq = m_header->head;
+    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(result.latency).count();
+    auto &sample = m_samples[seq % m_capacity];
+    sample.time = now;
+    sample.latency = static_cast<uint32_t>(std::clamp<int64_t>(micros, 0, UINT32_MAX));
+    sample.code = static_cast<int16_t>(std::clamp(result.code, -1, INT16_MAX));
+    sample.ok = result.ok ? 1 : 0;
+    sample.reserved = 0;
+    m_header->head = seq + 1;
+    if (m_header->since == 0)
+        m_header->since = now;
+    count(now, result.ok);
+}
+
+std::optional<ProbeHistory::Uptime> ProbeHistory::uptime(Window window) const
+{
+    auto hourly = window != Window::Hour;
+    auto const *buckets = hourly ? m_buckets + kMinuteBuckets : m_buckets;
+    auto slots = hourly ? kHourBuckets : kMinuteBuckets;
+    auto width = hourly ? kHourMillis : kMinuteMillis;
+    uint32_t span = window == Window::Day ? 24 : slots;
+
+    auto now = epochMillis();
+    auto current = now / width;
+    uint64_t total = 0;
+    uint64_t up = 0;
+    for (int64_t index = current; index > current - span; --index)
+    {
+        auto const &bucket = buckets[index % slots];
+        if (bucket.index != index || bucket.total == 0)
+            continue;
+        total += bucket.total;
+        up += bucket.up;
+    }
+    if (total == 0)
+        return std::nullopt;
+    auto covered = std::min(now - m_header->since, span * width);
+    return Uptime{static_cast<float>(up) / static_cast<float>(total),
+                  std::chrono::milliseconds(covered)};
+}
+
+size_t ProbeHistory::size() const
+{
+    return static_cast<size_t>(std::min<uint64_t>(m_header->head, m_capacity));
+}
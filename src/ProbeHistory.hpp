@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include "Probe.hpp"
+
+// Fixed-size ring of probe samples for one service, memory-mapped from the
+// mod's save directory so it survives restarts without a parse step.
+// Uptime over the last hour/day/week comes from per-minute and per-hour
+// up/total buckets stored after the ring, so it does not depend on how many
+// samples the ring holds and queries never rescan. Main thread only.
+class ProbeHistory
+{
+public:
+    enum class Window : uint8_t
+    {
+        Hour,
+        Day,
+        Week,
+    };
+
+    // On-disk record; the ring is an array of these after the header
+    struct Sample
+    {
+        // epoch milliseconds
+        int64_t time = 0;
+        // microseconds, saturated
+        uint32_t latency = 0;
+        // HTTP status, 0 when no response arrived
+        int16_t code = 0;
+        uint8_t ok = 0;
+        uint8_t reserved = 0;
+    };
+    static_assert(sizeof(Sample) == 16);
+
+    struct Uptime
+    {
+        // fraction of successful checks, 0..1
+        float ratio = 0.f;
+        // how much of the window the history reaches back, from the first
+        // sample ever recorded; shorter than the window while it is young
+        std::chrono::milliseconds covered{};
+    };
+
+    static constexpr uint32_t kDefaultCapacity = 16384;
+
+    // History of a service, opened (or created) on first use
+    static ProbeHistory *get(std::string const &service, uint32_t capacity = kDefaultCapacity);
+    // Close and delete the history of a service
+    static void erase(std::string const &service);
+
+    ProbeHistory(std::filesystem::path path, uint32_t capacity);
+    ~ProbeHistory();
+    ProbeHistory(ProbeHistory const &) = delete;
+    ProbeHistory &operator=(ProbeHistory const &) = delete;
+
+    // Append a probe outcome. A result that was already recorded (the same
+    // cached result delivered twice) is ignored.
+    void record(ProbeResult const &result);
+    // Successful checks inside the window, nullopt when there were none.
+    // Windows are whole buckets: the hour is the last 60 minutes including
+    // the current one, the day and week the last 24 and 168 hours, however
+    // many samples the ring itself still holds.
+    std::optional<Uptime> uptime(Window window) const;
+    size_t size() const;
+    bool isMapped() const { return m_header != nullptr; }
+
+private:
+    struct Header;
+    // On-disk up/total counts for one minute or hour
+    struct Bucket
+    {
+        // time / bucket width; a slot holding another index is stale
+        int64_t index = 0;
+        uint32_t total = 0;
+        uint32_t up = 0;
+    };
+    static_assert(sizeof(Bucket) == 16);
+
+    static constexpr uint32_t kMinuteBuckets = 60;
+    static constexpr uint32_t kHourBuckets = 7 * 24;
+
+    bool map();
+    void unmap();
+    size_t fileSize() const;
+    Sample const &at(uint64_t seq) const;
+    void count(int64_t time, bool ok);
+
+    std::filesystem::path m_path;
+    uint32_t m_capacity;
+    Header *m_header = nullptr;
+    Sample *m_samples = nullptr;
+    // kMinuteBuckets minutes, then kHourBuckets hours
+    Bucket *m_buckets = nullptr;
+    size_t m_mappedSize = 0;
+    void *m_mapping = nullptr;
+    std::chrono::steady_clock::time_point m_lastResult{};
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <Geode/Geode.hpp>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "Probe.hpp"
+#include "UrlParser.hpp"
+
+// Requests for the built-in services. StatusMonitor and StatusPopup build
+// their checks from these so identical probes coalesce in ProbeCache. Each
+// uses the cheapest probe mode that still tells up from down.
+namespace ProbeTargets
+{
+    // a hung connection must still end in a result, or the service would
+    // keep its last status and hold an executor slot forever
+    constexpr std::chrono::seconds kServiceTimeout{10};
+
+    // SERVERS_STATUS_URL_<SERVICE> points a built-in check somewhere else,
+    // e.g. at the local fault server from bench/ when testing
+    inline std::string urlFor(char const *service, std::string fallback)
+    {
+        auto name = std::string("SERVERS_STATUS_URL_") + service;
+        if (auto value = std::getenv(name.c_str()); value && *value)
+            return value;
+        return fallback;
+    }
+
+    inline ProbeRequest internet()
+    {
+        ProbeRequest req;
+        req.priority = ProbePriority::High;
+        req.url = urlFor("INTERNET", geode::Mod::get()->getSettingValue<std::string>("internet_url"));
+        // any answer at all means we are online, whatever its status; the
+        // internet race counts every HTTP code as a win
+        req.mode = ProbeMode::Head;
+        return req;
+    }
+
+    // The internet check races these: internet() first, then every valid
+    // URL of the comma or space separated fallback list. Each one gives up
+    // at the internet check deadline.
+    inline std::vector<ProbeRequest> internetTargets()
+    {
+        auto deadline = geode::Mod::get()->getSettingValue<float>("internet_timeout");
+        auto timeout = std::chrono::seconds(static_cast<int64_t>(std::ceil(std::max(deadline, 1.f))));
+
+        std::vector<ProbeRequest> targets{internet()};
+        auto list = urlFor("INTERNET_FALLBACK", geode::Mod::get()->getSettingValue<std::string>("internet_fallback_urls"));
+        size_t pos = 0;
+        while (pos < list.size())
+        {
+            auto end = list.find_first_of(", ", pos);
+            if (end == std::string::npos)
+                end = list.size();
+            auto url = list.substr(pos, end - pos);
+            pos = end + 1;
+            if (url.empty() || !UrlParser::isValid(url))
+                continue;
+            auto req = targets.front();
+            req.url = std::move(url);
+            targets.push_back(std::move(req));
+        }
+        for (auto &req : targets)
+            req.timeout = timeout;
+        return targets;
+    }
+
+    inline ProbeRequest boomlings()
+    {
+        ProbeRequest req;
+        req.priority = ProbePriority::High;
+        req.url = urlFor("BOOMLINGS", "http://www.boomlings.com/database/getGJLevels21.php");
+        req.timeout = kServiceTimeout;
+        req.method = "POST";
+        req.body = "type=2&secret=Wmfd2893gb7"; // most liked level
+        // the endpoint only answers POST; the level list itself is not needed
+        req.mode = ProbeMode::NoBody;
+        if (geode::Mod::get()->getSettingValue<bool>("verify_content"))
+        {
+            // a real level list instead of "-1" or a proxy's error page,
+            // matched over at most the first 16 KB; a level list page is
+            // well under that, so a bigger answer is something else
+            req.mode = ProbeMode::Capped;
+            req.bodyCap = 16384;
+            req.expect = {
+                {BodyAssertion::Kind::Contains, ":2:"},
+                {BodyAssertion::Kind::Excludes, "<html"},
+            };
+        }
+        return req;
+    }
+
+    inline ProbeRequest geode()
+    {
+        ProbeRequest req;
+        req.priority = ProbePriority::High;
+        req.url = urlFor("GEODE", "https://api.geode-sdk.org");
+        req.timeout = kServiceTimeout;
+        req.mode = ProbeMode::NoBody;
+        return req;
+    }
+
+    inline ProbeRequest argon()
+    {
+        ProbeRequest req;
+        req.priority = ProbePriority::High;
+        req.url = urlFor("ARGON", "https://argon.globed.dev/");
+        req.timeout = kServiceTimeout;
+        req.mode = ProbeMode::NoBody;
+        return req;
+    }
+
+    inline ProbeRequest custom(std::string const &url)
+    {
+        ProbeRequest req;
+        req.url = url;
+        req.mode = ProbeMode::NoBody;
+        req.timeout = std::chrono::seconds(5);
+        return req;
+    }
+}
@@ -0,0 +1,58 @@
+#include "ProbeTransport.hpp"
+
+using namespace geode::utils;
+
+ProbeTransport *ProbeTransport::get()
+{
+    static ProbeTransport instance;
+    return &instance;
+}
+
+void ProbeTransport::configure(web::WebRequest &req, ProbeRequest const &request) const
+{
+    // Offer HTTP/2 over TLS: concurrent probes to one host then share a
+    // single connection instead of each opening their own. Servers without
+    // it fall back to HTTP/1.1, which keeps connections alive by default.
+    if (request.url.starts_with("https://"))
+        req.version(web::HttpVersion::VERSION_2TLS);
+}
+
+bool ProbeTransport::begin(std::string_view name)
+{
+    auto &host = m_hosts[std::string(name)];
+    auto now = Clock::now();
+    // a guess from activity: the backend keeps the real answer to itself
+    bool likelyReused = host.open && (host.inFlight > 0 || now - host.lastActive < m_idleTimeout);
+    ++host.inFlight;
+    host.lastActive = now;
+
+    ++host.stats.stats.requests;
+    ++m_stats.requests;
+    if (likelyReused)
+    {
+        ++host.stats.stats.estimatedReused;
+        ++m_stats.estimatedReused;
+    }
+    return likelyReused;
+}
+
+void ProbeTransport::end(std::string_view name, bool likelyReused, int code, Clock::duration latency)
+{
+    auto it = m_hosts.find(std::string(name));
+    if (it == m_hosts.end())
+        return;
+    auto &host = it->second;
+    if (host.inFlight > 0)
+        --host.inFlight;
+    host.lastActive = Clock::now();
+    // no response means no connection left to reuse
+    host.open = code > 0;
+    if (code > 0)
+        (likelyReused ? host.stats.likelyWarm : host.stats.likelyCold).record(latency);
+}
+
+ProbeTransport::HostStats const *ProbeTransport::host(std::string_view name) const
+{
+    auto it = m_hosts.find(std::string(name));
+    return it == m_hosts.end() ? nullptr : &it->second.stats;
+}
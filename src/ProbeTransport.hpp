@@ -0,0 +1,82 @@
+#pragma once
+
+#include <Geode/utils/web.hpp>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "LatencyHistogram.hpp"
+#include "Probe.hpp"
+
+// Per-host connection bookkeeping for probes. The web backend owns the
+// actual connection pool and DNS cache; this sets requests up to make the
+// most of them (HTTP/2 where offered, so every probe to a host, built-in
+// or custom, multiplexes over one connection). The backend does not say
+// whether a request opened a new connection, so reuse is only estimated
+// from the host's recent activity, and everything built on it (hit rates,
+// the likely-warm and likely-cold latencies) is an estimate too. Main
+// thread only.
+class ProbeTransport
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Stats
+    {
+        uint64_t requests = 0;
+        // sent while a connection to the host was probably still open
+        uint64_t estimatedReused = 0;
+
+        float estimatedHitRate() const { return requests ? static_cast<float>(estimatedReused) / requests : 0.f; }
+    };
+
+    struct HostStats
+    {
+        Stats stats;
+        // split by the reuse estimate
+        LatencyHistogram likelyWarm;
+        LatencyHistogram likelyCold;
+    };
+
+    static ProbeTransport *get();
+
+    void configure(geode::utils::web::WebRequest &req, ProbeRequest const &request) const;
+
+    // A request to the host goes out now; returns whether it will probably
+    // reuse an open connection (an estimate, see above)
+    bool begin(std::string_view host);
+    // The request finished; code 0 means no response (connection failed,
+    // timed out or was dropped)
+    void end(std::string_view host, bool likelyReused, int code, Clock::duration latency);
+
+    Stats const &stats() const { return m_stats; }
+    // null for hosts never probed
+    HostStats const *host(std::string_view host) const;
+    template <class F>
+    void forEachHost(F &&f) const
+    {
+        for (auto const &[name, host] : m_hosts)
+            f(name, host.stats);
+    }
+
+    // How long servers are assumed to keep an idle connection open
+    void setIdleTimeout(Clock::duration timeout) { m_idleTimeout = timeout; }
+
+private:
+    struct Host
+    {
+        size_t inFlight = 0;
+        // a response came back on the last request
+        bool open = false;
+        Clock::time_point lastActive{};
+        HostStats stats;
+    };
+
+    std::unordered_map<std::string, Host> m_hosts;
+    // common server keep-alive; the backend itself keeps idle connections
+    // for about two minutes
+    Clock::duration m_idleTimeout = std::chrono::seconds(60);
+    Stats m_stats;
+};
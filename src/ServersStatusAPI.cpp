@@ -0,0 +1,58 @@
+#define GEODE_DEFINE_EVENT_EXPORTS
+#include "../include/ServersStatus.hpp"
+
+#include <chrono>
+
+#include "StatusBus.hpp"
+
+using namespace geode::prelude;
+
+namespace
+{
+    servers_status::Status toStatus(ServiceState const &state)
+    {
+        using ms = std::chrono::milliseconds;
+        servers_status::Status out;
+        out.known = !state.restored;
+        out.online = state.online;
+        out.code = state.code;
+        out.p50Ms = std::chrono::duration_cast<ms>(state.latency.p50).count();
+        out.p90Ms = std::chrono::duration_cast<ms>(state.latency.p90).count();
+        out.p99Ms = std::chrono::duration_cast<ms>(state.latency.p99).count();
+        out.lastOk = state.lastOk.seconds;
+        out.checkedAt = state.checkedAt.seconds;
+        return out;
+    }
+}
+
+Result<servers_status::Status> servers_status::getStatus(std::string service)
+{
+    if (service != "internet" && service != "boomlings" && service != "geode" && service != "argon")
+        return Err(fmt::format("unknown service '{}'", service));
+    auto state = StatusBus::get()->find(service);
+    return Ok(state ? toStatus(*state) : Status{});
+}
+
+Result<uint64_t> servers_status::onStatusChanged(StatusCallback callback)
+{
+    if (!callback)
+        return Err("empty callback");
+    auto subscription = StatusBus::get()->subscribe(
+        [callback = std::move(callback)](ServiceState const &state, bool changed) {
+            if (changed && !state.restored)
+                callback(state.service, toStatus(state));
+        });
+    return Ok(subscription.release());
+}
+
+Result<> servers_status::removeListener(uint64_t handle)
+{
+    StatusBus::get()->unsubscribe(handle);
+    return Ok();
+}
+
+Result<> servers_status::refresh()
+{
+    StatusBus::get()->requestRefresh();
+    return Ok();
+}
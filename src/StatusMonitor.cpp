@@ -8,14 +8,24 @@
 #include <Geode/utils/async.hpp>
 #include <Geode/utils/web.hpp>
 #include <ctime>
-#include <fstream>
-#include <iomanip>
-#include <matjson.hpp>
-#include <sstream>
 #include <string>
 
+#include "CustomProbes.hpp"
+#include "IoWorker.hpp"
+#include "ProbeBackoff.hpp"
+#include "ProbeCache.hpp"
+#include "ProbeDependencies.hpp"
+#include "ProbeExecutor.hpp"
+#include "ProbeHistory.hpp"
+#include "ProbeRace.hpp"
+#include "ProbeScheduler.hpp"
+#include "ProbeTargets.hpp"
+#include "ProbeTransport.hpp"
+#include "StatusAggregate.hpp"
+#include "StatusBus.hpp"
 #include "StatusStorage.hpp"
 #include "Timestamp.hpp"
+#include "TransitionNotifier.hpp"
 
 
 using namespace geode::prelude;
@@ -30,93 +40,180 @@ bool StatusMonitor::init() {
   float refresh = Mod::get()->getSettingValue<float>("refresh_rate");
   float padding = Mod::get()->getSettingValue<float>("padding");
   constexpr float kFallbackRefresh = 30.f;
-
-  // Load global custom status OK from JSON storage
-  m_custom_ok = true;
-  {
-    std::ifstream in((Mod::get()->getSaveDir() / "status.json").string(),
-                     std::ios::in | std::ios::binary);
-    if (in.is_open()) {
-      std::ostringstream ss;
-      ss << in.rdbuf();
-      auto str = ss.str();
-      auto json = matjson::parse(str).unwrapOr(matjson::Value());
-      m_custom_ok = json["all_online"].asBool().unwrapOr(true);
-
-      // Notify for any custom nodes that became offline
-      auto nodes = StatusStorage::load();
-      for (auto const &n : nodes) {
-        if (!n.online) {
-          // show notification only once per node until it comes back online
-          if (m_custom_notified.insert(n.id).second) {
-            auto last =
-                n.last_ping.empty() ? std::string("unknown") : n.last_ping;
-            Notification::create(
-                fmt::format("Connection Lost to {} at {}", n.name, last),
-                NotificationIcon::Error)
-                ->show();
-          }
-        } else {
-          // if it's online again, clear the notified flag
-          if (m_custom_notified.find(n.id) != m_custom_notified.end()) {
-            m_custom_notified.erase(n.id);
-          }
-        }
-      }
-    }
-  }
-
+  // state changes this close together share one notification
+  constexpr auto kNotifyWindow = std::chrono::seconds(5);
+
+  // show what the last session ended with; nothing here waits on storage
+  // or the network, probing starts after the startup delay
+  restoreLastStates();
+
+  // every outage reaches the user through one coalescing notifier, so a
+  // dropped connection is a single toast instead of one per service
+  m_notifier.setWindow(kNotifyWindow);
+  m_notifier.setSink([](std::string const &message) {
+    if (Mod::get()->getSettingValue<bool>("notification"))
+      Notification::create(message, NotificationIcon::Error)->show();
+  });
   m_icon->setColor({100, 100, 100}); // set the icon color to grey
   addChild(m_icon);
-  applySettings();
+  reloadSettings();
 
+  // every built-in check is a target on the shared probe scheduler, which
+  // spreads them across the refresh interval instead of firing all at once
   float interval = refresh > 0.f ? refresh : kFallbackRefresh;
-  this->schedule(schedule_selector(StatusMonitor::updateStatus), interval);
-  this->updateStatus(0.f);
+  auto scheduler = ProbeScheduler::get();
+  auto period = ProbeScheduler::fromSeconds(interval);
+  m_internetProbe = scheduler->add("internet", period,
+                                   [this]() { checkInternetStatus(); });
+  m_boomlingsProbe = scheduler->add("boomlings", period,
+                                    [this]() { checkBoomlingsStatus(); });
+  m_geodeProbe =
+      scheduler->add("geode", period, [this]() { checkGeodeStatus(); });
+  m_argonProbe =
+      scheduler->add("argon", period, [this]() { checkArgonStatus(); });
+
+  // the game loads its own assets and sends its own requests right after
+  // the menu opens; the first checks wait and then go out one at a time
+  auto delay = ProbeScheduler::fromSeconds(
+      Mod::get()->getSettingValue<float>("startup_delay"));
+  for (auto id :
+       {m_internetProbe, m_boomlingsProbe, m_geodeProbe, m_argonProbe}) {
+    scheduler->fireIn(id, delay);
+    delay += kStartupStagger;
+  }
+
+  // remote services are only reachable through the internet; while it is
+  // down they are marked unreachable instead of each waiting out a timeout
+  auto deps = ProbeDependencies::get();
+  for (auto [service, id] : {std::pair{"boomlings", m_boomlingsProbe},
+                             std::pair{"geode", m_geodeProbe},
+                             std::pair{"argon", m_argonProbe}}) {
+    deps->add(service, [this, service, id](std::string const *upstream) {
+      if (upstream)
+        markUnreachable(service, *upstream);
+      else
+        ProbeScheduler::get()->fireSoon(id);
+    });
+    deps->depend(service, "internet");
+  }
+
+  applyBackoffConfig();
+  auto custom = CustomProbes::get();
+  custom->setInterval(period);
+  m_customListener = custom->listen([this](std::string const &id) {
+    reportCustom(id);
+    updateCustomOk();
+  });
+  // the popup and other mods ask this monitor instead of probing themselves
+  StatusBus::get()->setRefreshHandler([this]() { refreshStale(); });
+
+  ProbeCache::get()->setTtl(ProbeScheduler::fromSeconds(
+      Mod::get()->getSettingValue<float>("probe_cache_ttl")));
+  ProbeExecutor::get()->setLimits(
+      Mod::get()->getSettingValue<int>("max_concurrent_probes"),
+      Mod::get()->getSettingValue<int>("max_probes_per_host"));
+
+  // write-behind for the custom node store
+  StatusStorage::setFlushWindow(
+      Mod::get()->getSettingValue<float>("storage_flush_interval"));
+  this->schedule(schedule_selector(StatusMonitor::tick),
+                 std::chrono::duration<float>(ProbeScheduler::kResolution)
+                     .count());
+  updateIconColor();
+  this->scheduleOnce(schedule_selector(StatusMonitor::startProbing),
+                     std::chrono::duration<float>(delay).count());
 
   // listen for setting changes so UI updates immediately
   m_settingListeners.push_back(geode::listenForSettingChanges<bool>(
       "enabled",
-      [this](bool) { geode::queueInMainThread([this]() { applySettings(); }); },
+      [this](bool) {
+        geode::queueInMainThread([this]() { reloadSettings(); });
+      },
       Mod::get()));
   m_settingListeners.push_back(geode::listenForSettingChanges<int>(
       "opacity",
-      [this](int) { geode::queueInMainThread([this]() { applySettings(); }); },
+      [this](int) {
+        geode::queueInMainThread([this]() { reloadSettings(); });
+      },
       Mod::get()));
   m_settingListeners.push_back(geode::listenForSettingChanges<float>(
       "scale",
       [this](float) {
-        geode::queueInMainThread([this]() { applySettings(); });
+        geode::queueInMainThread([this]() { reloadSettings(); });
       },
       Mod::get()));
   m_settingListeners.push_back(geode::listenForSettingChanges<std::string>(
       "position",
       [this](const std::string &) {
-        geode::queueInMainThread([this]() { applySettings(); });
+        geode::queueInMainThread([this]() { reloadSettings(); });
       },
       Mod::get()));
   m_settingListeners.push_back(geode::listenForSettingChanges<float>(
       "padding",
       [this](float) {
-        geode::queueInMainThread([this]() { applySettings(); });
+        geode::queueInMainThread([this]() { reloadSettings(); });
       },
       Mod::get()));
   m_settingListeners.push_back(geode::listenForSettingChanges<bool>(
       "disableInLevel",
-      [this](bool) { geode::queueInMainThread([this]() { applySettings(); }); },
+      [this](bool) {
+        geode::queueInMainThread([this]() { reloadSettings(); });
+      },
       Mod::get()));
   m_settingListeners.push_back(geode::listenForSettingChanges<float>(
       "refresh_rate",
       [this](float newRefresh) {
         geode::queueInMainThread([this, newRefresh]() {
-          this->unschedule(schedule_selector(StatusMonitor::updateStatus));
           float interval = newRefresh > 0.f ? newRefresh : kFallbackRefresh;
-          this->schedule(schedule_selector(StatusMonitor::updateStatus),
-                         interval);
+          auto period = ProbeScheduler::fromSeconds(interval);
+          auto scheduler = ProbeScheduler::get();
+          for (auto id : {m_internetProbe, m_boomlingsProbe, m_geodeProbe,
+                          m_argonProbe}) {
+            scheduler->setInterval(id, period);
+          }
+          CustomProbes::get()->setInterval(period);
+          applyBackoffConfig();
           this->updateStatus(0.f);
         });
       },
       Mod::get()));
+  m_settingListeners.push_back(geode::listenForSettingChanges<float>(
+      "backoff_max",
+      [this](float) {
+        geode::queueInMainThread([this]() { applyBackoffConfig(); });
+      },
+      Mod::get()));
+  m_settingListeners.push_back(geode::listenForSettingChanges<int>(
+      "breaker_threshold",
+      [this](int) {
+        geode::queueInMainThread([this]() { applyBackoffConfig(); });
+      },
+      Mod::get()));
+  m_settingListeners.push_back(geode::listenForSettingChanges<float>(
+      "storage_flush_interval",
+      [](float window) { StatusStorage::setFlushWindow(window); },
+      Mod::get()));
+  m_settingListeners.push_back(geode::listenForSettingChanges<float>(
+      "probe_cache_ttl",
+      [](float ttl) {
+        ProbeCache::get()->setTtl(ProbeScheduler::fromSeconds(ttl));
+      },
+      Mod::get()));
+  m_settingListeners.push_back(geode::listenForSettingChanges<int>(
+      "max_concurrent_probes",
+      [](int limit) {
+        ProbeExecutor::get()->setLimits(
+            limit, Mod::get()->getSettingValue<int>("max_probes_per_host"));
+      },
+      Mod::get()));
+  m_settingListeners.push_back(geode::listenForSettingChanges<int>(
+      "max_probes_per_host",
+      [](int limit) {
+        ProbeExecutor::get()->setLimits(
+            Mod::get()->getSettingValue<int>("max_concurrent_probes"),
+            limit);
+      },
+      Mod::get()));
 
   return true;
 }
@@ -126,30 +223,218 @@ void StatusMonitor::onEnter() {
   applySettings();
 }
 
+StatusMonitor::~StatusMonitor() {
+  StatusBus::get()->setRefreshHandler(nullptr);
+  CustomProbes::get()->unlisten(m_customListener);
+  if (m_probing)
+    CustomProbes::get()->release();
+  auto scheduler = ProbeScheduler::get();
+  for (auto id :
+       {m_internetProbe, m_boomlingsProbe, m_geodeProbe, m_argonProbe}) {
+    scheduler->remove(id);
+  }
+  for (auto service : {"boomlings", "geode", "argon"})
+    ProbeDependencies::get()->remove(service);
+}
+
 void StatusMonitor::updateStatus(float) {
   applySettings();
+
+  // probe everything on the next scheduler tick
+  auto scheduler = ProbeScheduler::get();
+  for (auto id :
+       {m_internetProbe, m_boomlingsProbe, m_geodeProbe, m_argonProbe}) {
+    scheduler->fireSoon(id);
+  }
+  CustomProbes::get()->checkAll();
+  updateCustomOk();
   updateIconColor();
+}
 
-  {
-    std::ifstream in((Mod::get()->getSaveDir() / "status.json").string(),
-                     std::ios::in | std::ios::binary);
-    if (in.is_open()) {
-      std::ostringstream ss;
-      ss << in.rdbuf();
-      auto str = ss.str();
-      auto json = matjson::parse(str).unwrapOr(matjson::Value());
-      m_custom_ok = json["all_online"].asBool().unwrapOr(true);
-    } else {
-      m_custom_ok = true;
-    }
+void StatusMonitor::refreshStale() {
+  // results younger than the cache time are what the caller reads anyway;
+  // everything older is checked on the next scheduler tick
+  auto cache = ProbeCache::get();
+  auto scheduler = ProbeScheduler::get();
+  std::pair<ProbeScheduler::Id, ProbeRequest> const targets[] = {
+      {m_internetProbe, ProbeTargets::internet()},
+      {m_boomlingsProbe, ProbeTargets::boomlings()},
+      {m_geodeProbe, ProbeTargets::geode()},
+      {m_argonProbe, ProbeTargets::argon()},
+  };
+  for (auto const &[id, request] : targets) {
+    if (!cache->fresh(request))
+      scheduler->fireSoon(id);
   }
-  checkInternetStatus();
-  checkBoomlingsStatus();
-  checkGeodeStatus();
-  checkArgonStatus();
+  CustomProbes::get()->checkStale();
+}
+
+void StatusMonitor::startProbing(float) {
+  if (m_probing)
+    return;
+  m_probing = true;
+  auto started = std::chrono::steady_clock::now();
+  // custom endpoints are probed in the background for as long as the
+  // monitor lives, not only while their list is open
+  CustomProbes::get()->retain(kStartupStagger);
+  // custom nodes already offline from last session count as one outage
+  auto const &nodes = StatusStorage::nodes();
+  for (auto const &n : nodes)
+    reportCustom(n.id);
+  updateCustomOk();
+  log::info("startup delay over, {} custom statuses scheduled in {}us",
+            nodes.size(),
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - started)
+                .count());
+}
+
+void StatusMonitor::restoreLastStates() {
+  auto mod = Mod::get();
+  auto restore = [mod](char const *service, char const *lastOkKey,
+                       bool &ok) {
+    auto key = fmt::format("last_{}_online", service);
+    if (!mod->hasSavedValue(key))
+      return;
+    ok = mod->getSavedValue<bool>(key);
+    ServiceState state;
+    state.service = service;
+    state.online = ok;
+    state.lastOk = EpochTime{mod->getSavedValue<int64_t>(lastOkKey)};
+    state.restored = true;
+    StatusBus::get()->publish(std::move(state));
+  };
+  restore("internet", "last_internet_ok", m_internet_ok);
+  restore("boomlings", "last_boomlings_ok", m_boomlings_ok);
+  restore("geode", "last_geode_ok", m_geode_ok);
+  restore("argon", "last_argon_ok", m_argon_ok);
+  m_custom_ok = mod->getSavedValue<bool>("last_custom_online", true);
+}
+
+void StatusMonitor::updateCustomOk() {
+  bool customOk = StatusStorage::allOnline();
+  if (customOk == m_custom_ok)
+    return;
+  m_custom_ok = customOk;
+  Mod::get()->setSavedValue<bool>("last_custom_online", customOk);
   updateIconColor();
 }
 
+void StatusMonitor::tick(float dt) {
+  auto scheduler = ProbeScheduler::get();
+  scheduler->tick();
+  if (m_internetRace)
+    m_internetRace->tick();
+  m_notifier.tick();
+  // storage I/O finished on the worker reports back here, then whatever
+  // changed since is handed to it
+  IoWorker::get()->poll();
+  StatusStorage::flush();
+
+  m_statsElapsed += dt;
+  if (m_statsElapsed >= 60.f) {
+    m_statsElapsed = 0.f;
+    auto const &stats = scheduler->stats();
+    using ms = std::chrono::milliseconds;
+    log::debug("probe scheduler: {} queued, {} fired, lag last {}ms avg {}ms "
+               "max {}ms",
+               stats.queueDepth, stats.fired,
+               std::chrono::duration_cast<ms>(stats.lastLag).count(),
+               std::chrono::duration_cast<ms>(stats.avgLag).count(),
+               std::chrono::duration_cast<ms>(stats.maxLag).count());
+    auto const &exec = ProbeExecutor::get()->stats();
+    log::debug("probe executor: {} queued, {} in flight, wait avg {}ms "
+               "(built-in) {}ms (custom), max {}ms / {}ms",
+               exec.queued, exec.inFlight,
+               std::chrono::duration_cast<ms>(exec.avgWait[0]).count(),
+               std::chrono::duration_cast<ms>(exec.avgWait[1]).count(),
+               std::chrono::duration_cast<ms>(exec.maxWait[0]).count(),
+               std::chrono::duration_cast<ms>(exec.maxWait[1]).count());
+    auto const &cache = ProbeCache::get()->stats();
+    log::debug("probe cache: {} requests, {} body bytes downloaded",
+               cache.completed, cache.bytes);
+    auto io = IoWorker::get()->stats();
+    log::debug("storage io: {} jobs ({} coalesced, {} queued), worker busy "
+               "{}ms max {}ms, main thread waited {}ms max {}ms",
+               io.completed, io.coalesced, io.queued,
+               std::chrono::duration_cast<ms>(io.busy).count(),
+               std::chrono::duration_cast<ms>(io.maxJob).count(),
+               std::chrono::duration_cast<ms>(io.waited).count(),
+               std::chrono::duration_cast<ms>(io.maxWait).count());
+    log::debug("icon settings: applied {} times, skipped {} unchanged",
+               m_settingsApplied, m_settingsSkipped);
+    auto const &deps = ProbeDependencies::get()->stats();
+    log::debug("probe dependencies: {} checks skipped while upstream was "
+               "down, {} targets resumed",
+               deps.skipped, deps.resumed);
+    auto transport = ProbeTransport::get();
+    log::debug("probe transport: {}/{} requests estimated on open "
+               "connections ({:.0f}%)",
+               transport->stats().estimatedReused, transport->stats().requests,
+               transport->stats().estimatedHitRate() * 100.f);
+    transport->forEachHost([](std::string const &host,
+                              ProbeTransport::HostStats const &stats) {
+      if (stats.likelyWarm.count() == 0 || stats.likelyCold.count() == 0)
+        return;
+      // roughly what connection setup adds to the server's response time
+      log::debug("{}: likely warm p50 {}, likely cold p50 {}, {:.0f}% "
+                 "estimated reused",
+                 host,
+                 LatencyHistogram::formatDuration(
+                     stats.likelyWarm.percentile(50)),
+                 LatencyHistogram::formatDuration(
+                     stats.likelyCold.percentile(50)),
+                 stats.stats.estimatedHitRate() * 100.f);
+    });
+    for (auto const &[name, request] :
+         {std::pair{"internet", ProbeTargets::internet()},
+          std::pair{"boomlings", ProbeTargets::boomlings()},
+          std::pair{"geode", ProbeTargets::geode()},
+          std::pair{"argon", ProbeTargets::argon()}}) {
+      if (auto histogram = ProbeCache::get()->latency(request)) {
+        log::debug("{} latency: {} ({} samples)", name,
+                   LatencyHistogram::format(histogram->summary()),
+                   histogram->count());
+      }
+    }
+  }
+}
+
+ProbeBackoff::Config StatusMonitor::backoffConfig() {
+  ProbeBackoff::Config config;
+  float refresh = Mod::get()->getSettingValue<float>("refresh_rate");
+  config.base = ProbeScheduler::fromSeconds(refresh > 0.f ? refresh : 30.f);
+  config.maxBackoff = std::max(
+      config.base,
+      ProbeScheduler::fromSeconds(
+          Mod::get()->getSettingValue<float>("backoff_max")));
+  config.openAfter = static_cast<uint32_t>(
+      std::max<int64_t>(Mod::get()->getSettingValue<int>("breaker_threshold"),
+                        1));
+  return config;
+}
+
+void StatusMonitor::applyBackoffConfig() {
+  auto config = backoffConfig();
+  for (auto backoff : {&m_internetBackoff, &m_boomlingsBackoff,
+                       &m_geodeBackoff, &m_argonBackoff}) {
+    backoff->setConfig(config);
+  }
+  CustomProbes::get()->setBackoffConfig(config);
+}
+
+void StatusMonitor::reschedule(char const *name, ProbeScheduler::Id id,
+                               ProbeBackoff &backoff, bool ok) {
+  auto before = backoff.state();
+  auto delay = backoff.next(ok);
+  ProbeScheduler::get()->fireIn(id, delay);
+  if (backoff.state() != before) {
+    log::debug("{} is now {}, next check in {}s", name,
+               ProbeBackoff::name(backoff.state()),
+               std::chrono::duration_cast<std::chrono::seconds>(delay).count());
+  }
+}
+
 StatusMonitor *StatusMonitor::create() {
   auto ret = new StatusMonitor();
   if (ret && ret->init()) {
@@ -164,216 +449,371 @@ void StatusMonitor::updateIconColor() {
   if (!m_icon)
     return;
 
-  // all services down -> red
-  if (!m_custom_ok && !m_geode_ok && !m_boomlings_ok && !m_internet_ok &&
-      !m_argon_ok) {
+  bool const up[] = {m_custom_ok, m_geode_ok, m_boomlings_ok, m_internet_ok,
+                     m_argon_ok};
+  switch (aggregateStatus(up)) {
+  case StatusAggregate::AllDown:
     m_icon->setColor({255, 0, 0});
-    return;
-  }
-
-  // all services up -> green
-  if (m_custom_ok && m_geode_ok && m_boomlings_ok && m_internet_ok &&
-      m_argon_ok) {
+    break;
+  case StatusAggregate::AllUp:
     m_icon->setColor({0, 255, 0});
-    return;
-  }
-
-  // some services down -> orange
-  if (!m_custom_ok || !m_geode_ok || !m_boomlings_ok || !m_internet_ok ||
-      !m_argon_ok) {
+    break;
+  case StatusAggregate::Partial:
     m_icon->setColor({255, 165, 0});
-    return;
+    break;
+  case StatusAggregate::Unknown:
+    m_icon->setColor({100, 100, 100});
+    break;
   }
+}
 
-  // default color
-  m_icon->setColor({100, 100, 100});
+IconSettings IconSettings::load() {
+  auto mod = Mod::get();
+  IconSettings settings;
+  settings.enabled = mod->getSettingValue<bool>("enabled");
+  settings.opacity = mod->getSettingValue<int>("opacity");
+  settings.scale = mod->getSettingValue<float>("scale");
+  settings.padding = mod->getSettingValue<float>("padding");
+  settings.disableInLevel = mod->getSettingValue<bool>("disableInLevel");
+
+  auto position = mod->getSettingValue<std::string>("position");
+  if (position == "Top Left")
+    settings.position = IconPosition::TopLeft;
+  else if (position == "Bottom Right")
+    settings.position = IconPosition::BottomRight;
+  else if (position == "Bottom Left")
+    settings.position = IconPosition::BottomLeft;
+  else
+    settings.position = IconPosition::TopRight;
+  return settings;
+}
+
+void StatusMonitor::reloadSettings() {
+  m_settings = IconSettings::load();
+  applySettings();
 }
 
 void StatusMonitor::applySettings() {
   if (!m_icon)
     return;
 
-  bool isEnabled = Mod::get()->getSettingValue<bool>("enabled");
-  int opacity = Mod::get()->getSettingValue<int>("opacity");
-  float scale = Mod::get()->getSettingValue<float>("scale");
-  auto position = Mod::get()->getSettingValue<std::string>("position");
-  float padding = Mod::get()->getSettingValue<float>("padding");
-
+  auto const &s = m_settings;
   auto winSize = CCDirector::sharedDirector()->getWinSize();
+  bool inLevel = PlayLayer::get() != nullptr;
+  bool first = !m_applied;
+  auto const *old = first ? nullptr : &*m_applied;
+
+  bool moved = first || s.position != old->position ||
+               s.padding != old->padding ||
+               !winSize.equals(m_appliedWinSize);
+  bool scaled = first || s.scale != old->scale;
+  bool faded = first || s.opacity != old->opacity;
+  bool shown = first || s.enabled != old->enabled ||
+               s.disableInLevel != old->disableInLevel ||
+               inLevel != m_appliedInLevel;
+  if (!moved && !scaled && !faded && !shown) {
+    ++m_settingsSkipped;
+    return;
+  }
+  ++m_settingsApplied;
+
   // position the wifi icon according to settings
-  if (position == "Top Right") {
-    m_icon->setPosition(
-        {winSize.width - 5 - padding, winSize.height - 5 - padding});
-    m_icon->setAnchorPoint({1, 1});
-  } else if (position == "Top Left") {
-    m_icon->setPosition({5 + padding, winSize.height - 5 - padding});
-    m_icon->setAnchorPoint({0, 1});
-  } else if (position == "Bottom Right") {
-    m_icon->setPosition({winSize.width - 5 - padding, 5 + padding});
-    m_icon->setAnchorPoint({1, 0});
-  } else if (position == "Bottom Left") {
-    m_icon->setAnchorPoint({0, 0});
-    m_icon->setPosition({5 + padding, 5 + padding});
+  if (moved) {
+    float padding = s.padding;
+    switch (s.position) {
+    case IconPosition::TopRight:
+      m_icon->setPosition(
+          {winSize.width - 5 - padding, winSize.height - 5 - padding});
+      m_icon->setAnchorPoint({1, 1});
+      break;
+    case IconPosition::TopLeft:
+      m_icon->setPosition({5 + padding, winSize.height - 5 - padding});
+      m_icon->setAnchorPoint({0, 1});
+      break;
+    case IconPosition::BottomRight:
+      m_icon->setPosition({winSize.width - 5 - padding, 5 + padding});
+      m_icon->setAnchorPoint({1, 0});
+      break;
+    case IconPosition::BottomLeft:
+      m_icon->setAnchorPoint({0, 0});
+      m_icon->setPosition({5 + padding, 5 + padding});
+      break;
+    }
   }
+  if (scaled)
+    m_icon->setScale(s.scale);
+  if (faded)
+    m_icon->setOpacity(s.opacity);
+  if (shown)
+    m_icon->setVisible(s.enabled && !(inLevel && s.disableInLevel));
+
+  m_applied = s;
+  m_appliedWinSize = winSize;
+  m_appliedInLevel = inLevel;
+  if (first)
+    updateIconColor();
+}
 
-  m_icon->setScale(scale);
-  m_icon->setOpacity(opacity);
-  m_icon->setVisible(isEnabled);
+void StatusMonitor::publish(char const *service, ProbeRequest const *request,
+                            bool online, int code, char const *lastOkKey) {
+  ServiceState state;
+  state.service = service;
+  state.online = online;
+  state.code = code;
+  if (request) {
+    state.target = request->url;
+    if (auto histogram = ProbeCache::get()->latency(*request))
+      state.latency = histogram->summary();
+  }
+  state.lastOk = EpochTime{Mod::get()->getSavedValue<int64_t>(lastOkKey)};
+  state.checkedAt = EpochTime::now();
+  Mod::get()->setSavedValue<bool>(fmt::format("last_{}_online", service),
+                                  online);
+  m_notifier.report(service, serviceName(service), online, state.lastOk);
+  StatusBus::get()->publish(std::move(state));
+  // dependents learn about it after the bus has this result
+  ProbeDependencies::get()->report(service, online);
+}
 
-  if (PlayLayer::get()) {
-    bool disableInLevel = Mod::get()->getSettingValue<bool>("disableInLevel");
-    if (disableInLevel) {
-      m_icon->setVisible(false);
-    }
+void StatusMonitor::markUnreachable(char const *service,
+                                    std::string const &upstream) {
+  std::string_view name = service;
+  if (name == "boomlings") {
+    m_boomlings_ok = false;
+    m_boomlingsTicket.cancel();
+  } else if (name == "geode") {
+    m_geode_ok = false;
+    m_geodeTicket.cancel();
+  } else if (name == "argon") {
+    m_argon_ok = false;
+    m_argonTicket.cancel();
   }
+  log::debug("{} unreachable while {} is down", serviceName(service),
+             upstream);
+  // not a failure of the service itself, so no notification either
+  ServiceState state;
+  state.service = service;
+  state.upstream = upstream;
+  state.lastOk = EpochTime{
+      Mod::get()->getSavedValue<int64_t>(fmt::format("last_{}_ok", service))};
+  state.checkedAt = EpochTime::now();
+  StatusBus::get()->publish(std::move(state));
   updateIconColor();
 }
 
+char const *StatusMonitor::serviceName(std::string_view service) {
+  if (service == "internet")
+    return "Internet";
+  if (service == "boomlings")
+    return "Boomlings Server";
+  if (service == "geode")
+    return "GeodeSDK Server";
+  if (service == "argon")
+    return "Argon Server";
+  return "Unknown";
+}
+
+void StatusMonitor::reportCustom(std::string const &id) {
+  auto key = "custom:" + id;
+  auto node = StatusStorage::get(StatusStorage::find(id));
+  if (!node) {
+    m_notifier.forget(key);
+    return;
+  }
+  // nodes without a usable URL never get checked
+  if (node->url.empty())
+    return;
+  m_notifier.report(key, node->name, node->online, node->last_ping);
+}
+
 void StatusMonitor::checkGeodeStatus() {
+  if (auto upstream = ProbeDependencies::get()->skip("geode")) {
+    markUnreachable("geode", *upstream);
+    return;
+  }
   log::debug("checking Geode server status");
-  auto lastGeodeCheck = Mod::get()->getSavedValue<std::string>("last_geode_ok");
-  bool notification = Mod::get()->getSettingValue<bool>("notification");
-  geode::async::spawn(
-      geode::utils::web::WebRequest().get("https://api.geode-sdk.org"),
-      [this, lastGeodeCheck,
-       notification](geode::utils::web::WebResponse response) {
-        if (!response.ok()) {
+  auto request = ProbeTargets::geode();
+  // scheduled checks always hit the network: a cached result would feed the
+  // backoff an outcome it already counted
+  m_geodeTicket = ProbeCache::get()->probe(
+      request, [this, request](ProbeResult const &result) {
+        ProbeHistory::get("geode")->record(result);
+        reschedule("geode", m_geodeProbe, m_geodeBackoff, result.ok);
+        if (!result.ok) {
           log::debug("GeodeSDK offline or unreachable");
-          if (notification) {
-            Notification::create(
-                fmt::format("Connection Lost to GeodeSDK Server at {}",
-                            lastGeodeCheck),
-                NotificationIcon::Error)
-                ->show();
-          }
           m_geode_ok = false;
-          geode::queueInMainThread([this]() { this->updateIconColor(); });
+          publish("geode", &request, false, result.code, "last_geode_ok");
+          this->updateIconColor();
           return;
         }
-        log::debug("GeodeSDK online at {}", lastGeodeCheck);
-        Mod::get()->setSavedValue<std::string>("last_geode_ok",
-                                               getLocalTimestamp());
+        log::debug("GeodeSDK online ({} bytes)", result.bytes);
+        Mod::get()->setSavedValue<int64_t>("last_geode_ok",
+                                           EpochTime::now().seconds);
         m_geode_ok = true;
-        geode::queueInMainThread([this]() { this->updateIconColor(); });
-        return;
-      });
+        publish("geode", &request, true, result.code, "last_geode_ok");
+        this->updateIconColor();
+      },
+      false);
 }
 
 void StatusMonitor::checkBoomlingsStatus() {
+  if (auto upstream = ProbeDependencies::get()->skip("boomlings")) {
+    markUnreachable("boomlings", *upstream);
+    return;
+  }
   log::debug("checking Boomlings server status");
-  auto lastBoomlingsCheck =
-      Mod::get()->getSavedValue<std::string>("last_boomlings_ok");
-  bool notification = Mod::get()->getSettingValue<bool>("notification");
-
-  auto url = "http://www.boomlings.com/database/getGJLevels21.php";
-  auto body = "type=2&secret=Wmfd2893gb7"; // most liked level
-
-  geode::async::spawn(
-      geode::utils::web::WebRequest().bodyString(body).post(url),
-      [this, lastBoomlingsCheck,
-       notification](geode::utils::web::WebResponse response) {
-        if (!response.ok() || response.code() != 200) {
-          log::error("Boomlings server offline or unreachable");
-          if (notification) {
-            Notification::create(
-                fmt::format("Connection Lost to Boomlings Server at {}",
-                            lastBoomlingsCheck),
-                NotificationIcon::Error)
-                ->show();
-          }
+  auto request = ProbeTargets::boomlings();
+  m_boomlingsTicket = ProbeCache::get()->probe(
+      request, [this, request](ProbeResult const &result) {
+        ProbeHistory::get("boomlings")->record(result);
+        // a verified check asks for a Range, which the server may honor
+        bool up =
+            result.ok && (result.code == 200 ||
+                          (result.code == 206 &&
+                           request.mode == ProbeMode::Capped));
+        reschedule("boomlings", m_boomlingsProbe, m_boomlingsBackoff, up);
+        if (!up) {
+          if (result.contentMismatch)
+            log::error("Boomlings server answered without level data");
+          else if (result.truncated)
+            log::error("Boomlings server sent more than {} bytes, could "
+                       "not verify",
+                       request.bodyCap);
+          else
+            log::error("Boomlings server offline or unreachable");
           m_boomlings_ok = false;
-          geode::queueInMainThread([this]() { this->updateIconColor(); });
+          publish("boomlings", &request, false, result.code,
+                  "last_boomlings_ok");
+          this->updateIconColor();
           return;
         }
-        log::debug("Boomlings server online at {}", lastBoomlingsCheck);
-        Mod::get()->setSavedValue<std::string>("last_boomlings_ok",
-                                               getLocalTimestamp());
+        log::debug("Boomlings server online ({} bytes)", result.bytes);
+        Mod::get()->setSavedValue<int64_t>("last_boomlings_ok",
+                                           EpochTime::now().seconds);
         m_boomlings_ok = true;
-        geode::queueInMainThread([this]() { this->updateIconColor(); });
-        return;
-      });
+        publish("boomlings", &request, true, result.code,
+                "last_boomlings_ok");
+        this->updateIconColor();
+      },
+      false);
 }
 
 void StatusMonitor::checkInternetStatus() {
   log::debug("checking internet status");
-  auto lastInternetCheck =
-      Mod::get()->getSavedValue<std::string>("last_internet_ok");
-  bool notification = Mod::get()->getSettingValue<bool>("notification");
-  auto url = Mod::get()->getSettingValue<std::string>("internet_url");
+  auto request = ProbeTargets::internet();
+  auto url = request.url;
   if (Mod::get()->getSettingValue<bool>("doWeHaveInternet")) {
-    if (GameToolbox::doWeHaveInternet()) {
-      log::debug("{} online at {}", url, lastInternetCheck);
-      Mod::get()->setSavedValue<std::string>("last_internet_ok",
-                                             getLocalTimestamp());
+    bool online = GameToolbox::doWeHaveInternet();
+    ProbeHistory::get("internet")->record(
+        ProbeResult{online, 0, std::chrono::steady_clock::now()});
+    reschedule("internet", m_internetProbe, m_internetBackoff, online);
+    if (online) {
+      log::debug("{} online", url);
+      Mod::get()->setSavedValue<int64_t>("last_internet_ok",
+                                         EpochTime::now().seconds);
       m_internet_ok = true;
+      publish("internet", nullptr, true, 0, "last_internet_ok");
       updateIconColor();
       return;
     }
     log::error(
         "{} offline or unreachable (used GameToolbox::doWeHaveInternet())",
         url);
-    if (notification) {
-      Notification::create(
-          fmt::format("Connection Lost to Internet at {}", lastInternetCheck),
-          NotificationIcon::Error)
-          ->show();
-    }
     m_internet_ok = false;
+    publish("internet", nullptr, false, 0, "last_internet_ok");
     updateIconColor();
     return;
   }
-  geode::async::spawn(
-      geode::utils::web::WebRequest().get(url),
-      [this, lastInternetCheck, url,
-       notification](geode::utils::web::WebResponse response) {
-        if (!response.ok()) {
-          log::error("{} offline or unreachable", url);
-          if (notification) {
-            Notification::create(
-                fmt::format("Connection Lost to Internet at {}",
-                            lastInternetCheck),
-                NotificationIcon::Error)
-                ->show();
-          }
+  // still racing from the last check; it reports soon enough
+  if (m_internetRace && !m_internetRace->finished())
+    return;
+
+  // race every configured target: the first to answer wins, the internet
+  // only counts as down when all of them failed or the deadline passed
+  auto targets = ProbeTargets::internetTargets();
+  constexpr auto kStagger = std::chrono::milliseconds(300);
+  auto deadline = ProbeScheduler::fromSeconds(
+      Mod::get()->getSettingValue<float>("internet_timeout"));
+  m_internetTickets.clear();
+  m_internetTickets.resize(targets.size());
+  m_internetRace = std::make_unique<ProbeRace>(
+      targets.size(), kStagger, deadline,
+      [this, targets](size_t i) {
+        m_internetTickets[i] = ProbeCache::get()->probe(
+            targets[i], [this, i](ProbeResult const &result) {
+              // any HTTP answer proves the network works, even a 403 or
+              // 405 from a host that does not like HEAD
+              bool answered = result.code > 0;
+              if (answered) {
+                m_internetWinner = result;
+                m_internetWinner.ok = true;
+              }
+              m_internetRace->report(i, answered, result.code);
+            },
+            false);
+      },
+      [this](size_t i) { m_internetTickets[i].cancel(); },
+      [this, targets](ProbeRace::Outcome const &outcome) {
+        auto detection =
+            std::chrono::duration_cast<std::chrono::milliseconds>(
+                outcome.elapsed)
+                .count();
+        reschedule("internet", m_internetProbe, m_internetBackoff,
+                   outcome.ok);
+        if (!outcome.ok) {
+          ProbeHistory::get("internet")->record(
+              ProbeResult{false, outcome.code, std::chrono::steady_clock::now(),
+                          outcome.elapsed});
+          log::error("internet offline or unreachable: {} of {} targets {} "
+                     "after {}ms",
+                     outcome.started, targets.size(),
+                     outcome.timedOut ? "tried, deadline passed" : "failed",
+                     detection);
           m_internet_ok = false;
-          geode::queueInMainThread([this]() { this->updateIconColor(); });
+          publish("internet", &targets.front(), false, outcome.code,
+                  "last_internet_ok");
+          this->updateIconColor();
           return;
         }
-        log::debug("{} online at {}", url, lastInternetCheck);
-        Mod::get()->setSavedValue<std::string>("last_internet_ok",
-                                               getLocalTimestamp());
+        auto const &winner = targets[outcome.winner];
+        ProbeHistory::get("internet")->record(m_internetWinner);
+        log::debug("{} online, answered first after {}ms ({} of {} targets "
+                   "tried)",
+                   winner.url, detection, outcome.started, targets.size());
+        Mod::get()->setSavedValue<int64_t>("last_internet_ok",
+                                           EpochTime::now().seconds);
         m_internet_ok = true;
-        geode::queueInMainThread([this]() { this->updateIconColor(); });
-        return;
+        publish("internet", &winner, true, outcome.code, "last_internet_ok");
+        this->updateIconColor();
       });
+  m_internetRace->begin();
 }
 
 void StatusMonitor::checkArgonStatus() {
+  if (auto upstream = ProbeDependencies::get()->skip("argon")) {
+    markUnreachable("argon", *upstream);
+    return;
+  }
   log::debug("checking Argon server status");
-  auto lastArgonCheck = Mod::get()->getSavedValue<std::string>("last_argon_ok");
-  bool notification = Mod::get()->getSettingValue<bool>("notification");
-  geode::async::spawn(
-      geode::utils::web::WebRequest().get("https://argon.globed.dev/"),
-      [this, lastArgonCheck,
-       notification](geode::utils::web::WebResponse response) {
-        if (!response.ok() || response.code() != 200) {
+  auto request = ProbeTargets::argon();
+  m_argonTicket = ProbeCache::get()->probe(
+      request, [this, request](ProbeResult const &result) {
+        ProbeHistory::get("argon")->record(result);
+        reschedule("argon", m_argonProbe, m_argonBackoff,
+                   result.ok && result.code == 200);
+        if (!result.ok || result.code != 200) {
           log::debug("Argon offline or unreachable");
-          if (notification) {
-            Notification::create(
-                fmt::format("Connection Lost to Argon Server at {}",
-                            lastArgonCheck),
-                NotificationIcon::Error)
-                ->show();
-          }
           m_argon_ok = false;
-          geode::queueInMainThread([this]() { this->updateIconColor(); });
+          publish("argon", &request, false, result.code, "last_argon_ok");
+          this->updateIconColor();
           return;
         }
-        log::debug("Argon online at {}", lastArgonCheck);
-        Mod::get()->setSavedValue<std::string>("last_argon_ok",
-                                               getLocalTimestamp());
+        log::debug("Argon online ({} bytes)", result.bytes);
+        Mod::get()->setSavedValue<int64_t>("last_argon_ok",
+                                           EpochTime::now().seconds);
         m_argon_ok = true;
-        geode::queueInMainThread([this]() { this->updateIconColor(); });
-        return;
-      });
+        publish("argon", &request, true, result.code, "last_argon_ok");
+        this->updateIconColor();
+      },
+      false);
 }
\ No newline at end of file
@@ -1,9 +1,39 @@
 #pragma once
 
 #include <Geode/Geode.hpp>
+#include <memory>
+#include <optional>
+
+#include "ProbeBackoff.hpp"
+#include "ProbeCache.hpp"
+#include "ProbeRace.hpp"
+#include "ProbeScheduler.hpp"
+#include "TransitionNotifier.hpp"
 
 using namespace geode::prelude;
 
+enum class IconPosition : uint8_t
+{
+    TopRight,
+    TopLeft,
+    BottomRight,
+    BottomLeft,
+};
+
+// Icon settings as of the last change, so applying them needs no lookups
+struct IconSettings
+{
+    bool enabled = true;
+    int opacity = 255;
+    float scale = 1.f;
+    IconPosition position = IconPosition::TopRight;
+    float padding = 0.f;
+    bool disableInLevel = false;
+
+    static IconSettings load();
+    bool operator==(IconSettings const &) const = default;
+};
+
 class StatusMonitor : public CCMenu
 {
 protected:
@@ -20,17 +50,80 @@ protected:
     bool m_geode_ok = false;
     bool m_argon_ok = false;
     bool m_custom_ok = true;
+    uint64_t m_customListener = 0;
+
+    ProbeScheduler::Id m_internetProbe;
+    ProbeScheduler::Id m_boomlingsProbe;
+    ProbeScheduler::Id m_geodeProbe;
+    ProbeScheduler::Id m_argonProbe;
+    // the internet check races several targets
+    std::unique_ptr<ProbeRace> m_internetRace;
+    std::vector<ProbeTicket> m_internetTickets;
+    ProbeResult m_internetWinner;
+    ProbeTicket m_boomlingsTicket;
+    ProbeTicket m_geodeTicket;
+    ProbeTicket m_argonTicket;
+    ProbeBackoff m_internetBackoff;
+    ProbeBackoff m_boomlingsBackoff;
+    ProbeBackoff m_geodeBackoff;
+    ProbeBackoff m_argonBackoff;
+    float m_statsElapsed = 0.f;
+    // custom endpoints are retained once the startup delay is over
+    bool m_probing = false;
+
+    IconSettings m_settings;
+    // what the icon currently shows; applySettings only touches what differs
+    std::optional<IconSettings> m_applied;
+    CCSize m_appliedWinSize;
+    bool m_appliedInLevel = false;
+    uint64_t m_settingsApplied = 0;
+    uint64_t m_settingsSkipped = 0;
 
     std::vector<geode::ListenerHandle *> m_settingListeners;
     geode::ListenerHandle m_layerListener{};
-    std::unordered_set<std::string> m_custom_notified;
+    TransitionNotifier m_notifier;
 
 public:
+    ~StatusMonitor();
     void onEnter() override;
     static StatusMonitor *create();
+    // Probe every built-in service on the next scheduler tick
     void updateStatus(float);
+    // Probe what has no result younger than the cache time; for refresh
+    // requests from the popup and other mods
+    void refreshStale();
+    void tick(float);
+    // End of the startup delay: start checking custom endpoints
+    void startProbing(float);
+    // Bring the icon in line with the settings snapshot, the window size and
+    // whether a level is open; cheap when none of them changed
     void applySettings();
+    // Rebuild the settings snapshot, then apply it
+    void reloadSettings();
+
+    // Backoff policy for every target, from the current settings
+    static ProbeBackoff::Config backoffConfig();
 
 protected:
+    // first checks after the startup delay go out this far apart
+    static constexpr auto kStartupStagger = std::chrono::milliseconds(250);
+
     void updateIconColor();
+    // Show the states the last session saved until the first checks finish
+    void restoreLastStates();
+    // Recompute the custom aggregate and remember it for the next start
+    void updateCustomOk();
+    void applyBackoffConfig();
+    // Share a finished check on the status bus; request is null when no
+    // HTTP probe was involved
+    void publish(char const *service, ProbeRequest const *request, bool online, int code, char const *lastOkKey);
+    // Share that a service is not checked while an upstream target is down
+    void markUnreachable(char const *service, std::string const &upstream);
+    // Name of a built-in service in notifications
+    static char const *serviceName(std::string_view service);
+    // Tell the notifier about a custom node's stored state
+    void reportCustom(std::string const &id);
+    // Feed a check result to the target's backoff policy and move its next
+    // check accordingly
+    void reschedule(char const *name, ProbeScheduler::Id id, ProbeBackoff &backoff, bool ok);
 };
\ No newline at end of file
@@ -1,17 +1,16 @@
 #include "StatusNode.hpp"
 #include <algorithm>
-#include <chrono>
 #include <string>
-#include <ctime>
+#include <vector>
 #include "Timestamp.hpp"
 #include <fmt/format.h>
-#include <Geode/utils/web.hpp>
-#include <Geode/utils/async.hpp>
-#include <regex>
+#include "CustomProbes.hpp"
+#include "ProbeCache.hpp"
+#include "ProbeTargets.hpp"
 #include "StatusStorage.hpp"
+#include "UrlParser.hpp"
 
 using namespace geode::prelude;
-using namespace geode::utils;
 
 namespace
 {
@@ -20,13 +19,12 @@ namespace
     const float kIconOffsetX = 24.f;
     const float kTextOffsetX = 50.f;
     const float kInputWidth = kNodeWidth - kTextOffsetX - 54.f;
-
 }
 
-StatusNode *StatusNode::create(std::string const &name, std::string const &url, std::string const &id)
+StatusNode *StatusNode::create()
 {
     auto ret = new StatusNode();
-    if (ret && ret->init(name, url, id))
+    if (ret && ret->init())
     {
         ret->autorelease();
         return ret;
@@ -35,7 +33,7 @@ StatusNode *StatusNode::create(std::string const &name, std::string const &url,
     return nullptr;
 }
 
-bool StatusNode::init(std::string const &name, std::string const &url, std::string const &id)
+bool StatusNode::init()
 {
     if (!CCLayer::init())
     {
@@ -46,10 +44,6 @@ bool StatusNode::init(std::string const &name, std::string const &url, std::stri
     this->setAnchorPoint({0.5f, 0.5f});
     this->setContentSize({kNodeWidth, kNodeHeight});
 
-    m_name = name;
-    m_url = url;
-    m_id = id;
-
     if (auto bg = CCSprite::create())
     {
         bg->setTextureRect(CCRectMake(0, 0, kNodeWidth, kNodeHeight));
@@ -76,18 +70,18 @@ bool StatusNode::init(std::string const &name, std::string const &url, std::stri
         this->addChild(m_statusCodeLabel, 1);
     }
 
-    // Load saved defaults from JSON storage
-    if (auto sn = StatusStorage::getById(StatusStorage::load(), m_id))
+    // Upstream picker: tapping cycles through the other endpoints
+    if (auto menu = CCMenu::create())
     {
-        m_name = sn->name;
-        m_url = sn->url;
-        if (!sn->last_ping.empty()) {
-            m_lastPingTimestamp = sn->last_ping;
-        }
+        menu->setPosition({0.f, 0.f});
+        this->addChild(menu, 2);
+        m_upstreamLabel = CCLabelBMFont::create("After: -", "chatFont.fnt");
+        m_upstreamLabel->setScale(0.4f);
+        auto upstreamBtn = CCMenuItemSpriteExtra::create(m_upstreamLabel, this, menu_selector(StatusNode::onUpstreamPressed));
+        upstreamBtn->setPosition({kIconOffsetX, 8.f});
+        menu->addChild(upstreamBtn);
     }
 
-    float refresh = Mod::get()->getSettingValue<float>("refresh_rate");
-
     // Name input
     m_nameInput = TextInput::create(kInputWidth, "Status name", "bigFont.fnt");
     if (m_nameInput)
@@ -96,15 +90,10 @@ bool StatusNode::init(std::string const &name, std::string const &url, std::stri
         m_nameInput->setMaxCharCount(64);
         m_nameInput->setTextAlign(TextInputAlign::Left);
         m_nameInput->setPosition({kTextOffsetX + kInputWidth / 2.f, kNodeHeight / 2.f + 16.f});
-        m_nameInput->setString(m_name);
         m_nameInput->setCallback([this](std::string const &value)
                                  {
             m_name = value;
-            auto nodes = StatusStorage::load();
-            bool online = false;
-            if (auto ex = StatusStorage::getById(nodes, m_id)) online = ex->online;
-            StatusStorage::upsertNode(nodes, StoredNode{m_id, m_name, m_url, online});
-            StatusStorage::save(nodes); });
+            this->persistDefinition(); });
         this->addChild(m_nameInput, 1);
     }
 
@@ -116,18 +105,12 @@ bool StatusNode::init(std::string const &name, std::string const &url, std::stri
         m_urlInput->setMaxCharCount(256);
         m_urlInput->setTextAlign(TextInputAlign::Left);
         m_urlInput->setPosition({kTextOffsetX + kInputWidth / 2.f, kNodeHeight / 2.f - 16.f});
-        m_urlInput->setString(m_url);
         m_urlInput->setCallback([this](std::string const &value)
                                 {
             m_url = value;
-            auto nodes = StatusStorage::load();
-            bool online = false;
-            if (auto ex = StatusStorage::getById(nodes, m_id)) online = ex->online;
-            StatusStorage::upsertNode(nodes, StoredNode{m_id, m_name, m_url, online});
-            StatusStorage::save(nodes);
+            this->persistDefinition();
             // Validate URL as user types; only notify once per invalid state
-            static const std::regex urlRe(R"((http|https):\/\/([\w_-]+(?:(?:\.[\w_-]+)+))([\w.,@?^=%&:\/~+#-]*[\w@?^=%&\/~+#-]))");
-            bool valid = std::regex_match(m_url, urlRe);
+            bool valid = UrlParser::isValid(m_url);
             if (!valid) {
                 if (!m_urlInvalidNotified) {
                     Notification::create("Invalid URL format", NotificationIcon::Error)->show();
@@ -140,12 +123,16 @@ bool StatusNode::init(std::string const &name, std::string const &url, std::stri
 
         m_lastPingLabel = CCLabelBMFont::create("Last ping: -", "chatFont.fnt");
         m_lastPingLabel->setScale(0.5f);
-        m_lastPingLabel->setPosition({kTextOffsetX + kInputWidth / 2.f, kNodeHeight / 2.f - 38.f});
+        m_lastPingLabel->setPosition({kTextOffsetX + kInputWidth / 2.f, kNodeHeight / 2.f - 34.f});
         m_lastPingLabel->setAlignment(kCCTextAlignmentCenter);
-        if (!m_lastPingTimestamp.empty()) {
-            m_lastPingLabel->setString((std::string("Last ping: ") + m_lastPingTimestamp).c_str());
-        }
         this->addChild(m_lastPingLabel, 1);
+
+        m_latencyLabel = CCLabelBMFont::create("", "chatFont.fnt");
+        m_latencyLabel->setScale(0.4f);
+        m_latencyLabel->setColor({230, 230, 230});
+        m_latencyLabel->setPosition({kTextOffsetX + kInputWidth / 2.f, kNodeHeight / 2.f - 41.f});
+        m_latencyLabel->setAlignment(kCCTextAlignmentCenter);
+        this->addChild(m_latencyLabel, 1);
     }
     // Buttons on the right: Ping and Delete
     if (auto menu = CCMenu::create())
@@ -175,14 +162,74 @@ bool StatusNode::init(std::string const &name, std::string const &url, std::stri
         menu->addChild(pingBtn);
         menu->addChild(delBtn);
     }
-    this->checkUrlStatus(true);
+    return true;
+}
+
+void StatusNode::onEnter()
+{
+    CCLayer::onEnter();
+    m_listener = CustomProbes::get()->listen([this](std::string const &id)
+                                             {
+        if (id == m_id)
+            this->refresh(); });
+    this->refresh();
+}
 
-    if (refresh > 0.f)
+void StatusNode::onExit()
+{
+    CustomProbes::get()->unlisten(m_listener);
+    m_listener = 0;
+    CCLayer::onExit();
+}
+
+void StatusNode::bind(std::string const &id, std::string const &fallbackName)
+{
+    m_id = id;
+    m_handle = StatusStorage::find(m_id);
+    m_name.clear();
+    m_url.clear();
+    if (auto sn = StatusStorage::get(m_handle))
     {
-        this->schedule(schedule_selector(StatusNode::updateStatusTimer), refresh);
+        m_name = sn->name;
+        m_url = sn->url;
     }
+    if (m_name.empty())
+        m_name = fallbackName;
+    m_urlInvalidNotified = false;
+    if (m_nameInput)
+        m_nameInput->setString(m_name);
+    if (m_urlInput)
+        m_urlInput->setString(m_url);
+    this->refresh();
+}
 
-    return true;
+void StatusNode::refresh()
+{
+    auto sn = StatusStorage::get(m_handle);
+    auto state = CustomProbes::get()->state(m_id);
+    bool pending = state && state->pending;
+
+    if (pending && state->manual && m_statusIcon)
+    {
+        m_statusIcon->setColor({255, 255, 255});
+        m_bg->setColor({230, 150, 10});
+    }
+    else
+    {
+        this->updateStatusColor(sn && sn->online);
+    }
+    if (m_statusCodeLabel)
+    {
+        int code = state && !pending ? state->code : 0;
+        auto text = code ? fmt::format("Status Code\n{}", code) : std::string("Status Code\n-");
+        // skipped while something it depends on is down
+        if (state && !pending && !state->upstream.empty())
+            text = "Status Code\nUnreachable";
+        m_statusCodeLabel->setString(text.c_str());
+    }
+    this->updateLastPingLabel(pending);
+    this->updateLatencyLabel();
+    this->updateUpstreamLabel();
 }
 
 void StatusNode::setStatusIconColor(ccColor3B const &color)
@@ -201,120 +248,126 @@ void StatusNode::updateStatusColor(bool online)
     const ccColor3B red{220, 60, 60};
     m_statusIcon->setColor(online ? green : red);
     m_bg->setColor(online ? ccColor3B{100, 200, 100} : ccColor3B{200, 100, 100});
-
-    // Save current online state persistently via JSON storage
-    auto nodes = StatusStorage::load();
-    std::string lastPing;
-    if (auto ex = StatusStorage::getById(nodes, m_id)) {
-        lastPing = ex->last_ping;
-    } else {
-        lastPing = m_lastPingTimestamp;
-    }
-    StatusStorage::upsertNode(nodes, StoredNode{m_id, m_name, m_url, online, lastPing});
-    StatusStorage::save(nodes);
 }
 
-void StatusNode::checkUrlStatus(bool useLastSaved)
+void StatusNode::updateLastPingLabel(bool pending)
 {
-    auto url = m_url;
-    if (url.empty())
+    // only format the time while the row is actually on screen
+    if (!m_lastPingLabel || !this->isRunning())
         return;
-
-    static const std::regex urlRe(R"((http|https):\/\/([\w_-]+(?:(?:\.[\w_-]+)+))([\w.,@?^=%&:\/~+#-]*[\w@?^=%&\/~+#-]))");
-    if (!std::regex_match(url, urlRe))
+    if (pending)
     {
-        Notification::create("Invalid URL format", NotificationIcon::Error)->show();
-        m_urlInvalidNotified = true;
+        m_lastPingLabel->setString("Last ping: pending");
         return;
     }
+    EpochTime lastPing;
+    if (auto sn = StatusStorage::get(m_handle))
+        lastPing = sn->last_ping;
+    auto text = fmt::format("Last ping: {}", TimestampFormatter::shared().format(lastPing, "-"));
+    m_lastPingLabel->setString(text.c_str());
+}
 
-    if (!useLastSaved)
+void StatusNode::updateLatencyLabel()
+{
+    if (!m_latencyLabel)
+        return;
+    auto histogram = m_url.empty() ? nullptr : ProbeCache::get()->latency(ProbeTargets::custom(m_url));
+    if (!histogram || histogram->count() == 0)
     {
-        m_statusIcon->setColor({255, 255, 255});
-        m_bg->setColor({230, 150, 10});
+        m_latencyLabel->setString("");
+        return;
     }
+    m_latencyLabel->setString(LatencyHistogram::format(histogram->summary()).c_str());
+}
 
-    if (useLastSaved)
+void StatusNode::updateUpstreamLabel()
+{
+    if (!m_upstreamLabel)
+        return;
+    std::string name = "-";
+    if (auto sn = StatusStorage::get(m_handle); sn && !sn->depends_on.empty())
     {
-        bool last = false;
-        if (auto sn = StatusStorage::getById(StatusStorage::load(), m_id))
-            last = sn->online;
-        this->updateStatusColor(last);
+        if (auto up = StatusStorage::get(StatusStorage::find(sn->depends_on)))
+            name = up->name.size() > 8 ? up->name.substr(0, 7) + "." : up->name;
     }
-
-    // Cancel any existing request
-    m_requestTask.cancel();
-
-    if (m_statusCodeLabel) m_statusCodeLabel->setString("Status Code\n-");
-    if (m_lastPingLabel) m_lastPingLabel->setString("Last ping: pending");
-
-    // status code
-    bool notify = !useLastSaved;
-
-    m_requestTask.spawn(
-        web::WebRequest()
-            .transferBody(false)
-            .followRedirects(true)
-            .timeout(std::chrono::seconds(5))
-            .get(url),
-        [this, notify](geode::utils::web::WebResponse res) {
-            bool ok = res.ok() && res.code() == 200;
-            int code = res.code();
-            std::string codeText = code ? ("Status Code\n" + std::to_string(code)) : std::string("Status Code\n-");
-
-            std::string timestamp = getLocalTimestamp();
-            std::string timeText = std::string("Last ping: ") + timestamp;
-
-            if (ok) {
-                auto nodes = StatusStorage::load();
-                if (auto ex = StatusStorage::getById(nodes, m_id)) {
-                    StoredNode copy = *ex;
-                    copy.online = true;
-                    copy.last_ping = timestamp;
-                    StatusStorage::upsertNode(nodes, copy);
-                } else {
-                    StatusStorage::upsertNode(nodes, StoredNode{m_id, m_name, m_url, true, timestamp});
-                }
-                StatusStorage::save(nodes);
-            }
-
-            std::string notifyFmt = ok ? "Ping successful ({})" : "Ping failed ({})";
-            std::string notifyMsg = fmt::format(fmt::runtime(notifyFmt), code);
-
-            queueInMainThread([this, ok, notify, codeText, timeText, timestamp, notifyMsg]
-                              {
-                this->updateStatusColor(ok);
-                if (m_statusCodeLabel) m_statusCodeLabel->setString(codeText.c_str());
-                if (ok) {
-                    if (m_lastPingLabel) m_lastPingLabel->setString(timeText.c_str());
-                    this->m_lastPingTimestamp = timestamp;
-                }
-                if (notify) {
-                    Notification::create(notifyMsg, ok ? NotificationIcon::Success : NotificationIcon::Error)->show();
-                } });
-        });
+    auto text = fmt::format("After: {}", name);
+    m_upstreamLabel->setString(text.c_str());
 }
 
-void StatusNode::updateStatusTimer(float)
+void StatusNode::persistDefinition()
 {
-    this->checkUrlStatus(true);
+    // keep the stored probe state and upstream, only the name/url changed
+    StoredNode node{m_id, m_name, m_url};
+    bool urlChanged = true;
+    if (auto ex = StatusStorage::get(m_handle)) {
+        node.online = ex->online;
+        node.last_ping = ex->last_ping;
+        node.depends_on = ex->depends_on;
+        urlChanged = ex->url != m_url;
+    }
+    m_handle = StatusStorage::upsertNode(node);
+    // the row would keep showing the old URL's status until the next
+    // periodic check
+    if (urlChanged && UrlParser::isValid(m_url))
+        CustomProbes::get()->urlChanged(m_id);
 }
 
 void StatusNode::onPingPressed(CCObject *)
 {
-    this->checkUrlStatus(false);
+    if (m_url.empty())
+        return;
+    if (!UrlParser::isValid(m_url))
+    {
+        Notification::create("Invalid URL format", NotificationIcon::Error)->show();
+        m_urlInvalidNotified = true;
+        return;
+    }
+
+    // the result outlives this row if it gets recycled meanwhile, so the
+    // notification only uses the result
+    CustomProbes::get()->check(m_id, true, [](ProbeResult const &res) {
+        bool ok = res.ok && res.code == 200;
+        std::string notifyFmt = ok ? "Ping successful ({})" : "Ping failed ({})";
+        Notification::create(fmt::format(fmt::runtime(notifyFmt), res.code), ok ? NotificationIcon::Success : NotificationIcon::Error)->show();
+    });
+}
+
+void StatusNode::onUpstreamPressed(CCObject *)
+{
+    auto sn = StatusStorage::get(m_handle);
+    if (!sn)
+        return;
+    // none, then every other endpoint in list order, then none again
+    std::vector<std::string> choices{""};
+    for (auto const &node : StatusStorage::nodes())
+    {
+        if (node.id != m_id)
+            choices.push_back(node.id);
+    }
+    auto current = std::find(choices.begin(), choices.end(), sn->depends_on);
+    auto start = current == choices.end() ? 0 : current - choices.begin();
+    for (size_t step = 1; step <= choices.size(); ++step)
+    {
+        // endpoints that already depend on this one would make a cycle
+        auto const &next = choices[(start + step) % choices.size()];
+        if (CustomProbes::get()->setUpstream(m_id, next))
+            break;
+    }
+    this->updateUpstreamLabel();
 }
 
 void StatusNode::onDeletePressed(CCObject *)
 {
+    // the row may be rebound before the popup closes, remember the id
+    auto id = m_id;
     geode::createQuickPopup(
         "Delete Status",
         "Are you sure you want to delete this custom status?",
         "Cancel",
         "Delete",
         320.f,
-        [this](FLAlertLayer* layer, bool btn1) {
-            if (btn1) {
+        [this, id](FLAlertLayer* layer, bool btn1) {
+            if (btn1 && id == m_id) {
                 if (m_onDelete)
                     m_onDelete(this);
             }
@@ -323,10 +376,3 @@ void StatusNode::onDeletePressed(CCObject *)
         true
     );
 }
-
-void StatusNode::onExit()
-{
-    // Ensure any pending request is cancelled to avoid callbacks after node is gone
-    m_requestTask.cancel();
-    CCLayer::onExit();
-} 
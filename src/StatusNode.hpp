@@ -1,46 +1,60 @@
 #pragma once
 
 #include <Geode/Geode.hpp>
-#include <Geode/utils/async.hpp>
 #include <string>
 #include <functional>
+#include "NodeRegistry.hpp"
 
 using namespace geode::prelude;
-using namespace geode::utils;
 
+// One row of the custom status list. Rows are recycled while scrolling, so
+// a row owns no probe state: it is bound to a stored endpoint id and renders
+// what StatusStorage and CustomProbes know about it.
 class StatusNode : public CCLayer
 {
 protected:
-    bool init(std::string const &name, std::string const &url, std::string const &id);
+    bool init() override;
+    void onEnter() override;
     void onExit() override;
     void onDeletePressed(CCObject *);
     void onPingPressed(CCObject *);
-    void updateStatusTimer(float);
+    void onUpstreamPressed(CCObject *);
 
     std::string m_name;
     std::string m_url;
     std::string m_id;
+    NodeHandle m_handle;
     TextInput *m_nameInput = nullptr;
     TextInput *m_urlInput = nullptr;
     CCSprite *m_statusIcon = nullptr;
     CCLabelBMFont *m_statusCodeLabel = nullptr;
     CCLabelBMFont *m_lastPingLabel = nullptr;
-    std::string m_lastPingTimestamp;
+    CCLabelBMFont *m_latencyLabel = nullptr;
+    CCLabelBMFont *m_upstreamLabel = nullptr;
     CCSprite *m_bg = nullptr;
-    geode::async::TaskHolder<geode::utils::web::WebResponse> m_requestTask;
+    uint64_t m_listener = 0;
     std::function<void(StatusNode *)> m_onDelete;
     bool m_urlInvalidNotified = false;
     void updateStatusColor(bool online);
-    void checkUrlStatus(bool useLastSaved = true);
+    void persistDefinition();
+    void updateLatencyLabel();
+    void updateLastPingLabel(bool pending);
+    void updateUpstreamLabel();
 
 public:
-    static StatusNode *create(std::string const &name, std::string const &url, std::string const &id);
-    static StatusNode *create(std::string const &name, std::string const &url) { return create(name, url, name); }
+    static StatusNode *create();
+
+    // Show the stored endpoint with this id (rebinding a recycled row);
+    // the fallback name is shown while the stored one is empty
+    void bind(std::string const &id, std::string const &fallbackName = "");
+    // Re-render from the current stored and probe state
+    void refresh();
 
     void setStatusIconColor(ccColor3B const &color);
     void setOnDelete(std::function<void(StatusNode *)> cb) { m_onDelete = std::move(cb); }
     const std::string &getName() const { return m_name; }
     const std::string &getUrl() const { return m_url; }
     const std::string &getID() const { return m_id; }
+    NodeHandle getHandle() const { return m_handle; }
     float getPreferredHeight() const { return this->getContentSize().height; }
 };
@@ -1,11 +1,9 @@
 #include <Geode/Geode.hpp>
-#include <Geode/binding/GameToolbox.hpp>
-#include <Geode/utils/web.hpp>
-#include <Geode/utils/async.hpp>
 #include <Geode/ui/GeodeUI.hpp>
 #include "StatusPopup.hpp"
-#include "StatusMonitor.hpp"
 #include "CustomStatusPopup.hpp"
+#include "ProbeHistory.hpp"
+#include "Timestamp.hpp"
 
 using namespace geode::prelude;
 
@@ -23,7 +21,7 @@ StatusPopup *StatusPopup::create()
 
 bool StatusPopup::init()
 {
-    if (!Popup::init(300.f, 200.f)) return false;
+    if (!Popup::init(300.f, 260.f)) return false;
 
     setTitle("Servers Status");
     auto winSize = CCDirector::sharedDirector()->getWinSize();
@@ -36,72 +34,41 @@ bool StatusPopup::init()
 
     // number of main status lines and spacing between them
     const int lines = 4;
-    const float spacing = 30.0f;
+    const float spacing = 46.0f;
     // top-most label Y (so labels are centered vertically as a group)
     const float topY = centerY + spacing * (lines - 1) / 2.0f;
-
-    // Internet
-    userInternet = CCLabelBMFont::create("Internet Status: Checking...", "bigFont.fnt");
-    userInternet->setColor({100, 100, 100});
-    userInternet->setScale(0.5f);
-    userInternet->setPosition({centerX, topY});
-    m_mainLayer->addChild(userInternet);
-    // timestamp under Internet
-    {
-        auto last = Mod::get()->getSavedValue<std::string>("last_internet_ok");
-        std::string text = std::string("Last checked: ") + last;
-        auto lbl = CCLabelBMFont::create(text.c_str(), "chatFont.fnt");
-        lbl->setScale(0.5f);
-        lbl->setPosition({centerX, topY - 15});
-        m_mainLayer->addChild(lbl);
-    }
-
-    // Boomlings (next line)
-    serverStatus = CCLabelBMFont::create("Boomlings Status: Checking...", "bigFont.fnt");
-    serverStatus->setColor({100, 100, 100});
-    serverStatus->setScale(0.5f);
-    serverStatus->setPosition({centerX, topY - spacing});
-    m_mainLayer->addChild(serverStatus);
-    // timestamp under Boomlings
-    {
-        auto last = Mod::get()->getSavedValue<std::string>("last_boomlings_ok");
-        std::string text = std::string("Last checked: ") + last;
-        auto lbl = CCLabelBMFont::create(text.c_str(), "chatFont.fnt");
-        lbl->setScale(0.5f);
-        lbl->setPosition({centerX, topY - spacing - 15});
-        m_mainLayer->addChild(lbl);
-    }
-
-    // GeodeSDK (next line)
-    geodeStatus = CCLabelBMFont::create("GeodeSDK Status: Checking...", "bigFont.fnt");
-    geodeStatus->setColor({100, 100, 100});
-    geodeStatus->setScale(0.5f);
-    geodeStatus->setPosition({centerX, topY - spacing * 2});
-    m_mainLayer->addChild(geodeStatus);
-    // timestamp under Geode
-    {
-        auto last = Mod::get()->getSavedValue<std::string>("last_geode_ok");
-        std::string text = std::string("Last checked: ") + last;
-        auto lbl = CCLabelBMFont::create(text.c_str(), "chatFont.fnt");
-        lbl->setScale(0.5f);
-        lbl->setPosition({centerX, topY - spacing * 2 - 15});
+    // response time percentiles and uptime under each timestamp
+    auto addDetailLabel = [&](char const *text, float y) {
+        auto lbl = CCLabelBMFont::create(text, "chatFont.fnt");
+        lbl->setScale(0.4f);
+        lbl->setColor({200, 200, 200});
+        lbl->setPosition({centerX, y});
         m_mainLayer->addChild(lbl);
-    }
+        return lbl;
+    };
 
-    // Argon (next line)
-    argonStatus = CCLabelBMFont::create("Argon Status: Checking...", "bigFont.fnt");
-    argonStatus->setColor({100, 100, 100});
-    argonStatus->setScale(0.5f);
-    argonStatus->setPosition({centerX, topY - spacing * 3});
-    m_mainLayer->addChild(argonStatus);
-    // timestamp under Argon
+    for (size_t i = 0; i < m_rows.size(); ++i)
     {
-        auto last = Mod::get()->getSavedValue<std::string>("last_argon_ok");
-        std::string text = std::string("Last checked: ") + last;
-        auto lbl = CCLabelBMFont::create(text.c_str(), "chatFont.fnt");
-        lbl->setScale(0.5f);
-        lbl->setPosition({centerX, topY - spacing * 3 - 15});
-        m_mainLayer->addChild(lbl);
+        auto &row = m_rows[i];
+        float y = topY - spacing * i;
+
+        row.status = CCLabelBMFont::create(fmt::format("{} Status: Checking...", row.title).c_str(), "bigFont.fnt");
+        row.status->setColor({100, 100, 100});
+        row.status->setScale(0.5f);
+        row.status->setPosition({centerX, y});
+        m_mainLayer->addChild(row.status);
+
+        // timestamp under the status
+        EpochTime last{Mod::get()->getSavedValue<int64_t>(fmt::format("last_{}_ok", row.service))};
+        auto text = fmt::format("Last checked: {}", TimestampFormatter::shared().format(last, "never"));
+        row.lastOk = CCLabelBMFont::create(text.c_str(), "chatFont.fnt");
+        row.lastOk->setScale(0.5f);
+        row.lastOk->setPosition({centerX, y - 15});
+        m_mainLayer->addChild(row.lastOk);
+
+        row.latency = addDetailLabel("Response time: -", y - 24);
+        row.uptime = addDetailLabel("Uptime: -", y - 33);
+        setServiceUptime(row.uptime, row.service);
     }
 
     // mod settings button
@@ -136,22 +103,14 @@ bool StatusPopup::init()
     customButton->setID("status-popup-open-custom");
     customMenu->addChild(customButton);
 
-    // check server status
-    checkInternetStatus();
-    checkBoomlingsStatus();
-    checkGeodeStatus();
-    checkArgonStatus();
+    // show what the monitor already knows, then follow its updates
+    auto bus = StatusBus::get();
+    for (auto const &state : bus->snapshot())
+        showService(state);
+    m_subscription = bus->subscribe([this](ServiceState const &state, bool)
+                                    { showService(state); });
     // immediate status refresh on the existing monitor instance
-    if (auto scene = CCDirector::sharedDirector()->getRunningScene())
-    {
-        if (auto node = scene->getChildByID("status-monitor"))
-        {
-            if (auto monitor = typeinfo_cast<StatusMonitor *>(node))
-            {
-                monitor->updateStatus(0.0f);
-            }
-        }
-    }
+    bus->requestRefresh();
 
     return true;
 }
@@ -161,114 +120,90 @@ void StatusPopup::onModSettings(CCObject *sender)
     openSettingsPopup(getMod());
 }
 
-void StatusPopup::checkInternetStatus()
+void StatusPopup::setServiceStatus(CCLabelBMFont *label, char const *name, bool online)
 {
-    log::debug("checking internet status");
-    // do we have internet?
-    if (Mod::get()->getSettingValue<bool>("doWeHaveInternet"))
-    {
-        if (GameToolbox::doWeHaveInternet())
-        {
-            userInternet->setString("Internet Status: Online");
-            userInternet->setColor({0, 255, 0});
-            return;
-        }
-        log::debug("Internet offline or unreachable");
-        userInternet->setString("Internet Status: Offline");
-        userInternet->setColor({255, 0, 0});
+    if (!label)
         return;
-    }
-    auto url = Mod::get()->getSettingValue<std::string>("internet_url");
-    m_internetTask.cancel();
-    m_internetTask.spawn(
-        geode::utils::web::WebRequest().get(url),
-        [this, url](geode::utils::web::WebResponse response) {
-            if (!response.ok()) {
-                log::debug("{} offline or unreachable", url);
-                if (userInternet) {
-                    userInternet->setString("Internet Status: Offline");
-                    userInternet->setColor({ 255, 0, 0 });
-                }
-                return;
-            }
-            log::debug("{} online", url);
-            if (userInternet) {
-                userInternet->setString("Internet Status: Online");
-                userInternet->setColor({ 0, 255, 0 });
-            } });
+    label->setString(fmt::format("{} Status: {}", name, online ? "Online" : "Offline").c_str());
+    label->setColor(online ? ccColor3B{0, 255, 0} : ccColor3B{255, 0, 0});
 }
 
-void StatusPopup::checkBoomlingsStatus()
+void StatusPopup::setServiceLatency(CCLabelBMFont *label, LatencyHistogram::Summary const &latency)
 {
-    log::debug("checking Boomlings server status");
-    auto url = "http://www.boomlings.com/database/getGJLevels21.php";
-    auto body = "type=2&secret=Wmfd2893gb7"; // most liked level
-
-    m_boomlingsTask.cancel();
-    m_boomlingsTask.spawn(
-        geode::utils::web::WebRequest()
-            .bodyString(body)
-            .post(url),
-        [this](geode::utils::web::WebResponse response) {
-            if (!response.ok() || response.code() != 200) {
-                log::debug("Boomlings server offline or unreachable");
-                if (serverStatus) {
-                    serverStatus->setString("Boomlings Status: Offline");
-                    serverStatus->setColor({255, 0, 0});
-                }
-                return;
-            }
-            log::debug("Boomlings server online");
-            if (serverStatus) {
-                serverStatus->setString("Boomlings Status: Online");
-                serverStatus->setColor({0, 255, 0});
-            } });
+    if (!label || latency.count == 0)
+        return;
+    auto text = "Response time: " + LatencyHistogram::format(latency);
+    label->setString(text.c_str());
 }
 
-void StatusPopup::checkGeodeStatus()
+void StatusPopup::setServiceUptime(CCLabelBMFont *label, char const *service)
 {
-    log::debug("checking GeodeSDK status");
-    m_geodeTask.cancel();
-    m_geodeTask.spawn(
-        geode::utils::web::WebRequest().get("https://api.geode-sdk.org"),
-        [this](geode::utils::web::WebResponse response) {
-        if (!response.ok()) {
-            log::debug("GeodeSDK offline or unreachable");
-            if (geodeStatus) {
-                geodeStatus->setString("GeodeSDK Status: Offline");
-                geodeStatus->setColor({ 255, 0, 0 });
-            }
-            return;
+    if (!label)
+        return;
+    using namespace std::chrono_literals;
+    struct Column
+    {
+        ProbeHistory::Window window;
+        char const *name;
+        std::chrono::hours length;
+    };
+    static constexpr Column columns[] = {
+        {ProbeHistory::Window::Hour, "1h", 1h},
+        {ProbeHistory::Window::Day, "24h", 24h},
+        {ProbeHistory::Window::Week, "7d", 7 * 24h},
+    };
+
+    auto history = ProbeHistory::get(service);
+    std::string text = "Uptime:";
+    for (auto const &column : columns)
+    {
+        auto uptime = history->uptime(column.window);
+        if (!uptime)
+        {
+            text += fmt::format(" {} -", column.name);
+            continue;
         }
-        log::debug("GeodeSDK online");
-        if (geodeStatus) {
-            geodeStatus->setString("GeodeSDK Status: Online");
-            geodeStatus->setColor({ 0, 255, 0 });
-        } });
+        auto percent = uptime->ratio * 100.f;
+        if (uptime->covered >= column.length)
+        {
+            text += fmt::format(" {} {:.1f}%", column.name, percent);
+            continue;
+        }
+        // a young history: say how far back it really goes, and skip the
+        // longer windows since they would repeat the same samples
+        auto minutes = std::chrono::duration_cast<std::chrono::minutes>(uptime->covered).count();
+        std::string span;
+        if (minutes < 120)
+            span = fmt::format("{}m", minutes);
+        else if (minutes < 48 * 60)
+            span = fmt::format("{}h", minutes / 60);
+        else
+            span = fmt::format("{}d", minutes / (24 * 60));
+        text += fmt::format(" {} {:.1f}%", span, percent);
+        break;
+    }
+    label->setString(text.c_str());
 }
 
-void StatusPopup::checkArgonStatus()
+void StatusPopup::showService(ServiceState const &state)
 {
-    log::debug("checking Argon server status");
-    auto url = "https://argon.globed.dev/";
-
-    m_argonTask.cancel();
-    m_argonTask.spawn(
-        geode::utils::web::WebRequest().get(url),
-        [this, url](geode::utils::web::WebResponse response) {
-                    if (!response.ok() || response.code() != 200) {
-                        log::debug("Argon server offline or unreachable");
-                        if (argonStatus) {
-                            argonStatus->setString("Argon Status: Offline");
-                            argonStatus->setColor({255, 0, 0});
-                        }
-                        return;
-                    }
-                    log::debug("Argon server online");
-                    if (argonStatus) {
-                        argonStatus->setString("Argon Status: Online");
-                        argonStatus->setColor({0, 255, 0});
-                    } });
+    for (auto &row : m_rows)
+    {
+        if (state.service != row.service)
+            continue;
+        setServiceStatus(row.status, row.title, state.online);
+        if (!state.upstream.empty() && row.status)
+        {
+            // not checked at all, so neither online nor offline
+            row.status->setString(fmt::format("{} Status: Unreachable ({} down)", row.title, state.upstream).c_str());
+            row.status->setColor({255, 165, 0});
+        }
+        auto text = fmt::format("Last checked: {}", TimestampFormatter::shared().format(state.lastOk, "never"));
+        row.lastOk->setString(text.c_str());
+        setServiceLatency(row.latency, state.latency);
+        setServiceUptime(row.uptime, row.service);
+        return;
+    }
 }
 
 void StatusPopup::onOpenCustomStatus(CCObject *)
@@ -2,35 +2,43 @@
 #include <Geode/Geode.hpp>
 #include <Geode/utils/async.hpp>
 
+#include <array>
+
+#include "StatusBus.hpp"
+
 using namespace geode::prelude;
 using namespace geode::utils;
 
 class StatusPopup : public Popup {
      protected:
+      // one block of labels per built-in service
+      struct ServiceRow {
+          char const* service;
+          char const* title;
+          CCLabelBMFont* status = nullptr;
+          CCLabelBMFont* lastOk = nullptr;
+          CCLabelBMFont* latency = nullptr;
+          CCLabelBMFont* uptime = nullptr;
+      };
+
       bool init() override;
-      void checkInternetStatus();
-      void checkBoomlingsStatus();
-      void checkGeodeStatus();
-      void checkArgonStatus();
+      void showService(ServiceState const& state);
+      void setServiceStatus(CCLabelBMFont* label, char const* name, bool online);
+      void setServiceLatency(CCLabelBMFont* label, LatencyHistogram::Summary const& latency);
+      void setServiceUptime(CCLabelBMFont* label, char const* service);
       void onModSettings(CCObject* sender);
       void onOpenCustomStatus(CCObject* sender);
 
-      CCLabelBMFont* userInternet = nullptr;
-      CCLabelBMFont* serverStatus = nullptr;
-      CCLabelBMFont* geodeStatus = nullptr;
-      CCLabelBMFont* argonStatus = nullptr;
-
-      geode::async::TaskHolder<geode::utils::web::WebResponse> m_internetTask;
-      geode::async::TaskHolder<geode::utils::web::WebResponse> m_boomlingsTask;
-      geode::async::TaskHolder<geode::utils::web::WebResponse> m_geodeTask;
-      geode::async::TaskHolder<geode::utils::web::WebResponse> m_argonTask;
+      std::array<ServiceRow, 4> m_rows{{
+          {"internet", "Internet"},
+          {"boomlings", "Boomlings"},
+          {"geode", "GeodeSDK"},
+          {"argon", "Argon"},
+      }};
+      // results come from StatusMonitor through the bus; the popup never
+      // probes on its own
+      StatusBus::Subscription m_subscription;
 
      public:
       static StatusPopup* create();
-      ~StatusPopup() {
-          m_internetTask.cancel();
-          m_boomlingsTask.cancel();
-          m_geodeTask.cancel();
-          m_argonTask.cancel();
-      }
 };
\ No newline at end of file
@@ -0,0 +1,143 @@
+#include "BodyMatcher.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SERVERS_STATUS_SSE2 1
+#endif
+
+namespace
+{
+    size_t findScalar(char const *data, size_t size, std::string_view needle, size_t from)
+    {
+        auto first = needle.front();
+        auto last = data + size - needle.size() + 1;
+        for (auto p = data + from; p < last;)
+        {
+            p = static_cast<char const *>(std::memchr(p, first, static_cast<size_t>(last - p)));
+            if (!p)
+                return std::string_view::npos;
+            if (std::memcmp(p + 1, needle.data() + 1, needle.size() - 1) == 0)
+                return static_cast<size_t>(p - data);
+            ++p;
+        }
+        return std::string_view::npos;
+    }
+}
+
+size_t findBytes(std::string_view haystack, std::string_view needle)
+{
+    if (needle.empty())
+        return 0;
+    if (needle.size() > haystack.size())
+        return std::string_view::npos;
+
+    auto data = haystack.data();
+    auto size = haystack.size();
+    size_t i = 0;
+#ifdef SERVERS_STATUS_SSE2
+    // compare the needle's first and last byte against 16 positions at once
+    // and only memcmp where both match
+    auto n = needle.size();
+    auto first = _mm_set1_epi8(needle.front());
+    auto last = _mm_set1_epi8(needle.back());
+    for (; i + n - 1 + 16 <= size; i += 16)
+    {
+        auto blockFirst = _mm_loadu_si128(reinterpret_cast<__m128i const *>(data + i));
+        auto blockLast = _mm_loadu_si128(reinterpret_cast<__m128i const *>(data + i + n - 1));
+        auto mask = static_cast<unsigned>(
+            _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(last, blockLast))));
+        while (mask)
+        {
+            auto bit = static_cast<size_t>(std::countr_zero(mask));
+            if (std::memcmp(data + i + bit + 1, needle.data() + 1, n > 2 ? n - 2 : 0) == 0)
+                return i + bit;
+            mask &= mask - 1;
+        }
+    }
+#endif
+    return findScalar(data, size, needle, i);
+}
+
+BodyMatcher::BodyMatcher(std::span<BodyAssertion const> assertions, size_t cap)
+    : m_assertions(assertions.begin(), assertions.end()), m_seen(assertions.size(), false), m_cap(cap)
+{
+    for (auto const &assertion : m_assertions)
+    {
+        m_overlap = std::max(m_overlap, assertion.needle.size());
+        if (assertion.kind == BodyAssertion::Kind::Contains)
+            ++m_missing;
+        else
+            m_hasExcludes = true;
+    }
+    m_overlap = m_overlap > 0 ? m_overlap - 1 : 0;
+    if (m_assertions.empty())
+        m_verdict = Verdict::Pass;
+}
+
+void BodyMatcher::scan(std::string_view data)
+{
+    for (size_t i = 0; i < m_assertions.size(); ++i)
+    {
+        if (m_seen[i])
+            continue;
+        auto const &assertion = m_assertions[i];
+        if (findBytes(data, assertion.needle) == std::string_view::npos)
+            continue;
+        m_seen[i] = true;
+        if (assertion.kind == BodyAssertion::Kind::Excludes)
+        {
+            m_verdict = Verdict::Fail;
+            return;
+        }
+        --m_missing;
+    }
+    if (m_missing == 0 && !m_hasExcludes)
+        m_verdict = Verdict::Pass;
+}
+
+BodyMatcher::Verdict BodyMatcher::feed(std::string_view chunk)
+{
+    if (m_verdict != Verdict::Pending)
+        return m_verdict;
+    chunk = chunk.substr(0, m_cap - m_consumed);
+    if (chunk.empty())
+        return finish();
+    m_consumed += chunk.size();
+
+    // matches straddling the previous chunk: carried tail + our head
+    if (!m_carry.empty())
+    {
+        auto joined = m_carry;
+        joined.append(chunk.substr(0, m_overlap));
+        scan(joined);
+        if (m_verdict != Verdict::Pending)
+            return m_verdict;
+    }
+    scan(chunk);
+    if (m_verdict != Verdict::Pending)
+        return m_verdict;
+
+    if (chunk.size() >= m_overlap)
+    {
+        m_carry.assign(chunk.substr(chunk.size() - m_overlap));
+    }
+    else
+    {
+        m_carry.append(chunk);
+        m_carry.erase(0, m_carry.size() - std::min(m_carry.size(), m_overlap));
+    }
+    if (m_consumed >= m_cap)
+        return finish();
+    return m_verdict;
+}
+
+BodyMatcher::Verdict BodyMatcher::finish()
+{
+    if (m_verdict == Verdict::Pending)
+        m_verdict = m_missing == 0 ? Verdict::Pass : Verdict::Fail;
+    return m_verdict;
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Content check on a probe response, so a 200 from a captive portal or a
+// CDN error page does not count as the service being up
+struct BodyAssertion
+{
+    enum class Kind : uint8_t
+    {
+        Contains,
+        Excludes,
+    };
+
+    Kind kind = Kind::Contains;
+    std::string needle;
+
+    bool operator==(BodyAssertion const &) const = default;
+};
+
+// Substring search used by the matcher: SSE2 when the target has it,
+// memchr-driven otherwise. Returns npos when needle is not in haystack.
+size_t findBytes(std::string_view haystack, std::string_view needle);
+
+// Evaluates assertions over a response body fed chunk by chunk, without
+// keeping the body: only the last (longest needle - 1) bytes are carried
+// over so matches across chunk boundaries are found. The verdict is known
+// as soon as an excluded needle shows up, or every required needle was
+// seen and nothing is excluded; otherwise reading stops at the cap.
+class BodyMatcher
+{
+public:
+    enum class Verdict : uint8_t
+    {
+        // keep feeding
+        Pending,
+        Pass,
+        Fail,
+    };
+
+    BodyMatcher(std::span<BodyAssertion const> assertions, size_t cap);
+
+    // Feed the next chunk; anything past the cap is ignored
+    Verdict feed(std::string_view chunk);
+    // End of the body (or of what will be read): required needles that
+    // never showed up fail, excluded ones that never did pass
+    Verdict finish();
+
+    Verdict verdict() const { return m_verdict; }
+    size_t consumed() const { return m_consumed; }
+
+private:
+    void scan(std::string_view data);
+
+    std::vector<BodyAssertion> m_assertions;
+    std::vector<bool> m_seen;
+    std::string m_carry;
+    size_t m_overlap = 0;
+    size_t m_cap = 0;
+    size_t m_consumed = 0;
+    size_t m_missing = 0;
+    bool m_hasExcludes = false;
+    Verdict m_verdict = Verdict::Pending;
+};
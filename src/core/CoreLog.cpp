@@ -0,0 +1,26 @@
+#include "CoreLog.hpp"
+
+#include <atomic>
+#include <cstdio>
+
+namespace
+{
+    // compactions log from their worker thread
+    std::atomic<CoreLog::Sink> g_sink{nullptr};
+}
+
+void CoreLog::setSink(Sink sink)
+{
+    g_sink.store(sink);
+}
+
+void CoreLog::write(Level level, std::string_view message)
+{
+    if (auto sink = g_sink.load())
+    {
+        sink(level, message);
+        return;
+    }
+    std::fprintf(stderr, "[%s] %.*s\n", level == Level::Error ? "error" : "info",
+                 static_cast<int>(message.size()), message.data());
+}
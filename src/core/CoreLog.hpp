@@ -0,0 +1,33 @@
+#pragma once
+
+#include <fmt/format.h>
+#include <string_view>
+#include <utility>
+
+// Logging for the core library, which cannot use Geode's logger. The mod
+// routes it into Geode's log on load; without a sink it goes to stderr.
+namespace CoreLog
+{
+    enum class Level
+    {
+        Info,
+        Error,
+    };
+
+    using Sink = void (*)(Level level, std::string_view message);
+
+    void setSink(Sink sink);
+    void write(Level level, std::string_view message);
+
+    template <class... Args>
+    void info(fmt::format_string<Args...> format, Args &&...args)
+    {
+        write(Level::Info, fmt::format(format, std::forward<Args>(args)...));
+    }
+
+    template <class... Args>
+    void error(fmt::format_string<Args...> format, Args &&...args)
+    {
+        write(Level::Error, fmt::format(format, std::forward<Args>(args)...));
+    }
+}
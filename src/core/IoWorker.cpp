@@ -0,0 +1,114 @@
+#include "IoWorker.hpp"
+
+#include <algorithm>
+
+IoWorker *IoWorker::get()
+{
+    static IoWorker instance;
+    return &instance;
+}
+
+IoWorker::IoWorker() : m_thread([this]() { run(); }) {}
+
+IoWorker::~IoWorker()
+{
+    {
+        std::lock_guard lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_thread.join();
+}
+
+void IoWorker::submit(Job job, Done done)
+{
+    submit(std::string(), std::move(job), std::move(done));
+}
+
+void IoWorker::submit(std::string key, Job job, Done done)
+{
+    {
+        std::lock_guard lock(m_mutex);
+        auto it = key.empty() ? m_queue.end()
+                              : std::find_if(m_queue.begin(), m_queue.end(),
+                                             [&](Entry const &e) { return e.key == key; });
+        if (it != m_queue.end())
+        {
+            it->job = std::move(job);
+            if (done)
+                it->done.push_back(std::move(done));
+            ++m_stats.coalesced;
+            return;
+        }
+        Entry entry{std::move(key), std::move(job), {}};
+        if (done)
+            entry.done.push_back(std::move(done));
+        m_queue.push_back(std::move(entry));
+        m_stats.queued = m_queue.size();
+    }
+    m_wake.notify_one();
+}
+
+size_t IoWorker::poll()
+{
+    decltype(m_completions) completions;
+    {
+        std::lock_guard lock(m_mutex);
+        if (m_completions.empty())
+            return 0;
+        completions.swap(m_completions);
+    }
+    for (auto &[done, ok] : completions)
+    {
+        for (auto &callback : done)
+            callback(ok);
+    }
+    return completions.size();
+}
+
+void IoWorker::wait()
+{
+    auto start = Clock::now();
+    std::unique_lock lock(m_mutex);
+    m_idle.wait(lock, [this]() { return m_queue.empty() && !m_busy; });
+    auto waited = Clock::now() - start;
+    m_stats.waited += waited;
+    m_stats.maxWait = std::max(m_stats.maxWait, waited);
+}
+
+IoWorker::Stats IoWorker::stats() const
+{
+    std::lock_guard lock(m_mutex);
+    return m_stats;
+}
+
+void IoWorker::run()
+{
+    std::unique_lock lock(m_mutex);
+    while (true)
+    {
+        m_wake.wait(lock, [this]() { return m_stop || !m_queue.empty(); });
+        if (m_queue.empty())
+            return;
+
+        auto entry = std::move(m_queue.front());
+        m_queue.pop_front();
+        m_stats.queued = m_queue.size();
+        m_busy = true;
+        lock.unlock();
+
+        auto start = Clock::now();
+        bool ok = entry.job();
+        auto elapsed = Clock::now() - start;
+
+        lock.lock();
+        m_busy = false;
+        ++m_stats.completed;
+        m_stats.busy += elapsed;
+        m_stats.maxJob = std::max(m_stats.maxJob, elapsed);
+        if (!entry.done.empty())
+            m_completions.emplace_back(std::move(entry.done), ok);
+        if (m_queue.empty())
+            m_idle.notify_all();
+    }
+}
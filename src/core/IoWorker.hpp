@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// One background thread for file I/O, so slow storage never stalls a frame.
+// Jobs run in submission order. Their completions are queued and run by
+// whoever calls poll(), which is the main thread tick in the mod.
+class IoWorker
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    // Runs on the worker; returns whether the I/O succeeded
+    using Job = std::function<bool()>;
+    using Done = std::function<void(bool ok)>;
+
+    struct Stats
+    {
+        size_t queued = 0;
+        uint64_t completed = 0;
+        // jobs replaced by a newer one for the same key before they ran
+        uint64_t coalesced = 0;
+        // time spent running jobs on the worker
+        Clock::duration busy{};
+        Clock::duration maxJob{};
+        // time callers spent blocked in wait(), the only part that can
+        // still show up as a frame hitch
+        Clock::duration waited{};
+        Clock::duration maxWait{};
+    };
+
+    static IoWorker *get();
+
+    IoWorker();
+    // Finishes the queue before returning
+    ~IoWorker();
+    IoWorker(IoWorker const &) = delete;
+    IoWorker &operator=(IoWorker const &) = delete;
+
+    void submit(Job job, Done done = nullptr);
+    // Like submit, but a queued job with the same key that has not started
+    // yet is replaced in place; its completion then reports this job's result
+    void submit(std::string key, Job job, Done done = nullptr);
+
+    // Run the completions of finished jobs; returns how many ran
+    size_t poll();
+    // Block until every job submitted so far has finished. Completions still
+    // only run from poll().
+    void wait();
+
+    Stats stats() const;
+
+private:
+    struct Entry
+    {
+        std::string key;
+        Job job;
+        std::vector<Done> done;
+    };
+
+    void run();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::deque<Entry> m_queue;
+    std::vector<std::pair<std::vector<Done>, bool>> m_completions;
+    bool m_busy = false;
+    bool m_stop = false;
+    Stats m_stats;
+    // started last, once everything above exists
+    std::thread m_thread;
+};
@@ -0,0 +1,82 @@
+#include "LatencyHistogram.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <fmt/format.h>
+
+size_t LatencyHistogram::bucketFor(uint64_t micros)
+{
+    if (micros < kSubBuckets)
+        return static_cast<size_t>(micros);
+    auto magnitude = std::min<uint32_t>(std::bit_width(micros) - 1, kMaxMagnitude);
+    auto shift = magnitude - kSubBucketBits;
+    auto sub = std::min<uint64_t>((micros >> shift) - kSubBuckets, kSubBuckets - 1);
+    return static_cast<size_t>(kSubBuckets * (shift + 1) + sub);
+}
+
+uint64_t LatencyHistogram::upperBound(size_t bucket)
+{
+    if (bucket < kSubBuckets)
+        return bucket;
+    auto shift = bucket / kSubBuckets - 1;
+    auto sub = bucket % kSubBuckets;
+    return ((kSubBuckets + sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(std::chrono::steady_clock::duration latency)
+{
+    auto micros = static_cast<uint64_t>(std::max<int64_t>(
+        std::chrono::duration_cast<Duration>(latency).count(), 0));
+    auto &bucket = m_counts[bucketFor(micros)];
+    // saturate instead of wrapping on absurdly long sessions
+    if (bucket != UINT32_MAX)
+        ++bucket;
+    ++m_count;
+    m_max = std::max(m_max, micros);
+}
+
+void LatencyHistogram::reset()
+{
+    m_counts.fill(0);
+    m_count = 0;
+    m_max = 0;
+}
+
+LatencyHistogram::Duration LatencyHistogram::percentile(double p) const
+{
+    if (m_count == 0)
+        return Duration(0);
+    auto rank = static_cast<uint64_t>(std::ceil(std::clamp(p, 0.0, 100.0) / 100.0 * m_count));
+    rank = std::max<uint64_t>(rank, 1);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount; ++i)
+    {
+        seen += m_counts[i];
+        if (seen >= rank)
+            return Duration(std::min(upperBound(i), m_max));
+    }
+    return Duration(m_max);
+}
+
+LatencyHistogram::Summary LatencyHistogram::summary() const
+{
+    return {percentile(50), percentile(90), percentile(99), max(), m_count};
+}
+
+std::string LatencyHistogram::formatDuration(Duration value)
+{
+    auto ms = value.count() / 1000.0;
+    if (ms < 1000.0)
+        return fmt::format("{:.0f}ms", ms);
+    return fmt::format("{:.1f}s", ms / 1000.0);
+}
+
+std::string LatencyHistogram::format(Summary const &summary)
+{
+    if (summary.count == 0)
+        return "no samples";
+    return fmt::format("p50 {}  p90 {}  p99 {}  max {}",
+                       formatDuration(summary.p50), formatDuration(summary.p90),
+                       formatDuration(summary.p99), formatDuration(summary.max));
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Fixed-memory latency histogram with HDR-style log-linear buckets: values
+// below kSubBuckets microseconds get one bucket each, and every power of two
+// above that is split into kSubBuckets linear buckets. Any reported
+// percentile is within 1/kSubBuckets (~6%) of the true value. Recording and
+// querying never allocate.
+class LatencyHistogram
+{
+public:
+    using Duration = std::chrono::microseconds;
+
+    struct Summary
+    {
+        Duration p50{};
+        Duration p90{};
+        Duration p99{};
+        Duration max{};
+        uint64_t count = 0;
+    };
+
+    void record(std::chrono::steady_clock::duration latency);
+    void reset();
+
+    // Upper bound of the bucket holding the p-th percentile (p in 0..100),
+    // never more than the largest recorded value
+    Duration percentile(double p) const;
+    Duration max() const { return Duration(m_max); }
+    uint64_t count() const { return m_count; }
+    Summary summary() const;
+
+    // "p50 120ms  p90 340ms  p99 1.2s  max 2.0s"
+    static std::string format(Summary const &summary);
+    static std::string formatDuration(Duration value);
+
+private:
+    static constexpr uint32_t kSubBucketBits = 4;
+    static constexpr uint64_t kSubBuckets = 1ull << kSubBucketBits;
+    // highest tracked magnitude, 2^27us is a little over two minutes
+    static constexpr uint32_t kMaxMagnitude = 27;
+    static constexpr size_t kBucketCount = kSubBuckets * (kMaxMagnitude - kSubBucketBits + 2);
+
+    static size_t bucketFor(uint64_t micros);
+    static uint64_t upperBound(size_t bucket);
+
+    std::array<uint32_t, kBucketCount> m_counts{};
+    uint64_t m_count = 0;
+    uint64_t m_max = 0;
+};
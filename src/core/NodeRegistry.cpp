@@ -0,0 +1,118 @@
+#include "NodeRegistry.hpp"
+
+void NodeRegistry::link(uint32_t index)
+{
+    auto &slot = m_slots[index];
+    slot.prev = m_tail;
+    slot.next = NodeHandle::kInvalid;
+    if (m_tail != NodeHandle::kInvalid)
+        m_slots[m_tail].next = index;
+    else
+        m_head = index;
+    m_tail = index;
+}
+
+void NodeRegistry::unlink(uint32_t index)
+{
+    auto &slot = m_slots[index];
+    if (slot.prev != NodeHandle::kInvalid)
+        m_slots[slot.prev].next = slot.next;
+    else
+        m_head = slot.next;
+    if (slot.next != NodeHandle::kInvalid)
+        m_slots[slot.next].prev = slot.prev;
+    else
+        m_tail = slot.prev;
+}
+
+NodeHandle NodeRegistry::upsert(StoredNode node)
+{
+    if (auto it = m_index.find(std::string_view(node.id)); it != m_index.end())
+    {
+        auto &slot = m_slots[it->second];
+        slot.node = std::move(node);
+        return {it->second, slot.generation};
+    }
+
+    uint32_t index;
+    if (m_free != NodeHandle::kInvalid)
+    {
+        index = m_free;
+        m_free = m_slots[index].next;
+    }
+    else
+    {
+        index = static_cast<uint32_t>(m_slots.size());
+        m_slots.emplace_back();
+    }
+
+    auto &slot = m_slots[index];
+    slot.node = std::move(node);
+    slot.alive = true;
+    m_index.emplace(slot.node.id, index);
+    link(index);
+    return {index, slot.generation};
+}
+
+NodeHandle NodeRegistry::find(std::string_view id) const
+{
+    auto it = m_index.find(id);
+    if (it == m_index.end())
+        return {};
+    return {it->second, m_slots[it->second].generation};
+}
+
+StoredNode *NodeRegistry::get(NodeHandle handle)
+{
+    if (handle.index >= m_slots.size())
+        return nullptr;
+    auto &slot = m_slots[handle.index];
+    if (!slot.alive || slot.generation != handle.generation)
+        return nullptr;
+    return &slot.node;
+}
+
+StoredNode const *NodeRegistry::get(NodeHandle handle) const
+{
+    return const_cast<NodeRegistry *>(this)->get(handle);
+}
+
+bool NodeRegistry::erase(NodeHandle handle)
+{
+    if (!this->get(handle))
+        return false;
+    auto &slot = m_slots[handle.index];
+    m_index.erase(m_index.find(std::string_view(slot.node.id)));
+    unlink(handle.index);
+    slot.node = StoredNode{};
+    slot.alive = false;
+    ++slot.generation;
+    slot.next = m_free;
+    m_free = handle.index;
+    return true;
+}
+
+void NodeRegistry::clear()
+{
+    // keep the slots so outstanding handles are invalidated, not aliased
+    m_index.clear();
+    m_head = m_tail = m_free = NodeHandle::kInvalid;
+    for (uint32_t i = 0; i < m_slots.size(); ++i)
+    {
+        auto &slot = m_slots[i];
+        if (slot.alive)
+        {
+            slot.node = StoredNode{};
+            slot.alive = false;
+            ++slot.generation;
+        }
+        slot.next = m_free;
+        m_free = i;
+    }
+}
+
+void NodeRegistry::reserve(size_t count)
+{
+    m_slots.reserve(count);
+    m_index.reserve(count);
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Timestamp.hpp"
+
+struct StoredNode
+{
+    std::string id;
+    std::string name;
+    std::string url;
+    bool online = false;
+    // last successful ping
+    EpochTime last_ping;
+    // id of another node this one is only checked while it is up, empty
+    // for none; every node depends on the internet check regardless
+    std::string depends_on;
+};
+
+// Stable reference to a registry slot. The generation is bumped whenever a
+// slot is freed, so a handle to a removed node never resolves to whatever
+// reuses its slot later.
+struct NodeHandle
+{
+    static constexpr uint32_t kInvalid = UINT32_MAX;
+
+    uint32_t index = kInvalid;
+    uint32_t generation = 0;
+
+    bool valid() const { return index != kInvalid; }
+    bool operator==(NodeHandle const &) const = default;
+};
+
+// Slot map of stored nodes indexed by id. Lookup by handle or id, update and
+// removal are O(1); iteration follows insertion order.
+class NodeRegistry
+{
+    struct Slot
+    {
+        StoredNode node;
+        uint32_t generation = 0;
+        uint32_t prev = NodeHandle::kInvalid;
+        uint32_t next = NodeHandle::kInvalid;
+        bool alive = false;
+    };
+
+    struct IdHash
+    {
+        using is_transparent = void;
+        size_t operator()(std::string_view id) const { return std::hash<std::string_view>{}(id); }
+    };
+
+    std::vector<Slot> m_slots;
+    std::unordered_map<std::string, uint32_t, IdHash, std::equal_to<>> m_index;
+    uint32_t m_head = NodeHandle::kInvalid;
+    uint32_t m_tail = NodeHandle::kInvalid;
+    uint32_t m_free = NodeHandle::kInvalid;
+
+    void link(uint32_t index);
+    void unlink(uint32_t index);
+
+public:
+    class const_iterator
+    {
+        NodeRegistry const *m_reg = nullptr;
+        uint32_t m_index = NodeHandle::kInvalid;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = StoredNode;
+        using difference_type = std::ptrdiff_t;
+        using pointer = StoredNode const *;
+        using reference = StoredNode const &;
+
+        const_iterator() = default;
+        const_iterator(NodeRegistry const *reg, uint32_t index) : m_reg(reg), m_index(index) {}
+
+        reference operator*() const { return m_reg->m_slots[m_index].node; }
+        pointer operator->() const { return &m_reg->m_slots[m_index].node; }
+        const_iterator &operator++()
+        {
+            m_index = m_reg->m_slots[m_index].next;
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            auto copy = *this;
+            ++*this;
+            return copy;
+        }
+        NodeHandle handle() const { return {m_index, m_reg->m_slots[m_index].generation}; }
+        bool operator==(const_iterator const &other) const { return m_index == other.m_index; }
+    };
+
+    // Insert a node or overwrite the one with the same id
+    NodeHandle upsert(StoredNode node);
+    NodeHandle find(std::string_view id) const;
+    StoredNode *get(NodeHandle handle);
+    StoredNode const *get(NodeHandle handle) const;
+    bool erase(NodeHandle handle);
+    void clear();
+    void reserve(size_t count);
+
+    size_t size() const { return m_index.size(); }
+    bool empty() const { return m_index.empty(); }
+    const_iterator begin() const { return {this, m_head}; }
+    const_iterator end() const { return {this, NodeHandle::kInvalid}; }
+};
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BodyMatcher.hpp"
+#include "ProbeExecutor.hpp"
+#include "UrlParser.hpp"
+
+// How much of the response a probe downloads
+enum class ProbeMode : uint8_t
+{
+    // the whole response body
+    Full,
+    // HEAD request, headers only
+    Head,
+    // the request's own method, body not downloaded
+    NoBody,
+    // the request's own method, asking for the first bodyCap bytes only;
+    // a server that ignores Range is cut off once it sends more
+    Capped,
+};
+
+// A single HTTP check against a service
+struct ProbeRequest
+{
+    std::string url;
+    std::string method = "GET";
+    std::string body;
+    ProbeMode mode = ProbeMode::Full;
+    uint32_t bodyCap = 0;
+    // checked over the first bodyCap bytes of the body, so the mode has to
+    // download it (Full or Capped)
+    std::vector<BodyAssertion> expect;
+    bool followRedirects = true;
+    std::chrono::seconds timeout{0}; // 0 -> no timeout
+    ProbePriority priority = ProbePriority::Normal;
+};
+
+struct ProbeResult
+{
+    // response.ok(), i.e. the request completed with a 2xx status
+    bool ok = false;
+    int code = 0;
+    std::chrono::steady_clock::time_point at{};
+    // from sending the request to receiving the response
+    std::chrono::steady_clock::duration latency{};
+    // response body bytes downloaded
+    uint64_t bytes = 0;
+    // estimated, not measured: sent while a connection to the host was
+    // probably still open (the web backend does not report it)
+    bool likelyReused = false;
+    // the server answered, but the body failed the request's assertions
+    bool contentMismatch = false;
+    // cut off after the body ran past bodyCap (Capped only); the status is
+    // unknown then
+    bool truncated = false;
+};
+
+// Method actually sent for a request in its probe mode
+inline std::string const &probeMethod(ProbeRequest const &request)
+{
+    static std::string const head = "HEAD";
+    return request.mode == ProbeMode::Head ? head : request.method;
+}
+
+// Host (with port) part of an absolute URL, used to group probes per host
+inline std::string_view probeHost(std::string_view url)
+{
+    if (auto parsed = UrlParser::parse(url))
+        return parsed->authority;
+    // not something the URL check accepts; split it the simple way
+    auto schemeEnd = url.find("://");
+    if (schemeEnd == std::string_view::npos)
+        return {};
+    auto rest = url.substr(schemeEnd + 3);
+    return rest.substr(0, rest.find_first_of("/?#"));
+}
@@ -0,0 +1,91 @@
+#include "ProbeBackoff.hpp"
+
+#include <algorithm>
+
+ProbeBackoff::ProbeBackoff() : ProbeBackoff(Config{})
+{
+}
+
+ProbeBackoff::ProbeBackoff(Config config)
+    : m_config(config), m_rng(std::random_device{}())
+{
+}
+
+char const *ProbeBackoff::name(State state)
+{
+    switch (state)
+    {
+    case State::Healthy:
+        return "healthy";
+    case State::Failing:
+        return "failing";
+    case State::Open:
+        return "circuit open";
+    case State::Recovering:
+        return "recovering";
+    }
+    return "unknown";
+}
+
+ProbeBackoff::Clock::duration ProbeBackoff::fast() const
+{
+    // quick recheck after a state change, but never slower than normal
+    auto quick = std::max<Clock::duration>(m_config.base / 4, std::chrono::seconds(2));
+    return std::min(quick, m_config.base);
+}
+
+ProbeBackoff::Clock::duration ProbeBackoff::jittered(Clock::duration delay)
+{
+    auto spread = static_cast<Clock::rep>(delay.count() * m_config.jitter);
+    if (spread <= 0)
+        return delay;
+    std::uniform_int_distribution<Clock::rep> dist(-spread, spread);
+    return std::max(Clock::duration(delay.count() + dist(m_rng)), Clock::duration(std::chrono::seconds(1)));
+}
+
+ProbeBackoff::Clock::duration ProbeBackoff::next(bool ok)
+{
+    if (ok)
+    {
+        m_failures = 0;
+        switch (m_state)
+        {
+        case State::Healthy:
+            return jittered(m_config.base);
+        case State::Failing:
+        case State::Open:
+            // half-open probe (or a retry) went through
+            m_state = State::Recovering;
+            m_successes = 1;
+            break;
+        case State::Recovering:
+            ++m_successes;
+            break;
+        }
+        if (m_successes >= m_config.stableAfter)
+        {
+            m_state = State::Healthy;
+            return jittered(m_config.base);
+        }
+        return jittered(fast());
+    }
+
+    m_successes = 0;
+    auto wasHealthy = m_state == State::Healthy;
+    if (m_state == State::Recovering)
+        m_failures = 0;
+    ++m_failures;
+
+    if (m_failures >= m_config.openAfter)
+    {
+        m_state = State::Open;
+        return jittered(m_config.maxBackoff);
+    }
+    m_state = State::Failing;
+    // confirm a fresh failure quickly, then back off
+    if (wasHealthy)
+        return jittered(fast());
+    auto shift = std::min<uint32_t>(m_failures - 1, 16);
+    auto delay = m_config.base * (Clock::rep(1) << shift);
+    return jittered(std::min(delay, m_config.maxBackoff));
+}
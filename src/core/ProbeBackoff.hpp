@@ -0,0 +1,59 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+
+// Adaptive refresh policy for one probe target. Healthy targets are checked
+// every base interval. Failures back off exponentially (with jitter) up to
+// a cap, and after openAfter consecutive failures the circuit opens: only an
+// occasional half-open probe is sent, at the cap. A target that just changed
+// state (first failure, or recovery) is rechecked quickly until it has been
+// stable for stableAfter results.
+class ProbeBackoff
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class State : uint8_t
+    {
+        Healthy,
+        Failing,
+        Open,
+        Recovering,
+    };
+
+    struct Config
+    {
+        Clock::duration base = std::chrono::seconds(60);
+        Clock::duration maxBackoff = std::chrono::minutes(10);
+        uint32_t openAfter = 5;
+        uint32_t stableAfter = 3;
+        // +- fraction applied to every delay
+        float jitter = 0.15f;
+    };
+
+    ProbeBackoff();
+    explicit ProbeBackoff(Config config);
+
+    void setConfig(Config config) { m_config = config; }
+    Config const &config() const { return m_config; }
+
+    // Feed a probe outcome; returns the delay until the next probe
+    Clock::duration next(bool ok);
+
+    State state() const { return m_state; }
+    uint32_t failures() const { return m_failures; }
+
+    static char const *name(State state);
+
+private:
+    Clock::duration fast() const;
+    Clock::duration jittered(Clock::duration delay);
+
+    Config m_config;
+    State m_state = State::Healthy;
+    uint32_t m_failures = 0;
+    uint32_t m_successes = 0;
+    std::minstd_rand m_rng;
+};
@@ -0,0 +1,194 @@
+#include "ProbeDependencies.hpp"
+
+#include <algorithm>
+#include <unordered_set>
+
+ProbeDependencies *ProbeDependencies::get()
+{
+    static ProbeDependencies instance;
+    return &instance;
+}
+
+ProbeDependencies::Node &ProbeDependencies::node(std::string const &name)
+{
+    auto [it, inserted] = m_nodes.try_emplace(name);
+    if (inserted)
+        it->second.name = name;
+    return it->second;
+}
+
+void ProbeDependencies::add(std::string const &target, Change change)
+{
+    node(target).change = std::move(change);
+}
+
+void ProbeDependencies::remove(std::string const &target)
+{
+    auto it = m_nodes.find(target);
+    if (it == m_nodes.end())
+        return;
+    auto &gone = it->second;
+    auto held = dependents(gone);
+    for (auto *up : gone.upstream)
+        std::erase(up->downstream, &gone);
+    for (auto *down : gone.downstream)
+        std::erase(down->upstream, &gone);
+    std::erase(held, &gone);
+    m_nodes.erase(it);
+    resume(held);
+}
+
+bool ProbeDependencies::depend(std::string const &target, std::string const &upstream)
+{
+    if (target == upstream)
+        return false;
+    auto &down = node(target);
+    auto &up = node(upstream);
+    if (std::ranges::find(down.upstream, &up) != down.upstream.end())
+        return true;
+    // the new edge closes a cycle if the target is already upstream of it
+    if (reaches(up, down))
+        return false;
+    down.upstream.push_back(&up);
+    up.downstream.push_back(&down);
+    return true;
+}
+
+void ProbeDependencies::undepend(std::string const &target, std::string const &upstream)
+{
+    auto down = m_nodes.find(target);
+    auto up = m_nodes.find(upstream);
+    if (down == m_nodes.end() || up == m_nodes.end())
+        return;
+    std::erase(down->second.upstream, &up->second);
+    std::erase(up->second.downstream, &down->second);
+    auto held = dependents(down->second);
+    held.push_back(&down->second);
+    resume(held);
+}
+
+void ProbeDependencies::report(std::string const &target, bool up)
+{
+    auto &reported = node(target);
+    auto state = up ? State::Up : State::Down;
+    if (reported.state == state)
+        return;
+    reported.state = state;
+    reported.blocked = false;
+    auto affected = dependents(reported);
+    if (up)
+    {
+        resume(affected);
+        return;
+    }
+
+    // callbacks may change the graph; go by name
+    std::vector<std::string> names;
+    for (auto *down : affected)
+    {
+        if (down->blocked)
+            continue;
+        down->blocked = true;
+        names.push_back(down->name);
+    }
+    for (auto const &name : names)
+    {
+        auto it = m_nodes.find(name);
+        if (it == m_nodes.end() || !it->second.blocked)
+            continue;
+        auto *upstream = m_nodes.contains(target) ? &m_nodes.at(target).name : nullptr;
+        if (it->second.change)
+            it->second.change(upstream);
+    }
+}
+
+std::string const *ProbeDependencies::skip(std::string const &target)
+{
+    auto it = m_nodes.find(target);
+    if (it == m_nodes.end())
+        return nullptr;
+    auto const *down = blocker(it->second);
+    if (!down)
+        return nullptr;
+    it->second.blocked = true;
+    ++m_stats.skipped;
+    return &down->name;
+}
+
+ProbeDependencies::Node const *ProbeDependencies::blocker(Node const &start) const
+{
+    std::vector<Node const *> stack(start.upstream.begin(), start.upstream.end());
+    std::unordered_set<Node const *> seen;
+    // depth first, but a direct upstream wins over one further away
+    for (auto *up : start.upstream)
+    {
+        if (up->state == State::Down)
+            return up;
+    }
+    while (!stack.empty())
+    {
+        auto *current = stack.back();
+        stack.pop_back();
+        if (!seen.insert(current).second)
+            continue;
+        if (current->state == State::Down)
+            return current;
+        stack.insert(stack.end(), current->upstream.begin(), current->upstream.end());
+    }
+    return nullptr;
+}
+
+bool ProbeDependencies::reaches(Node const &from, Node const &to) const
+{
+    std::vector<Node const *> stack{&from};
+    std::unordered_set<Node const *> seen;
+    while (!stack.empty())
+    {
+        auto *current = stack.back();
+        stack.pop_back();
+        if (current == &to)
+            return true;
+        if (!seen.insert(current).second)
+            continue;
+        stack.insert(stack.end(), current->upstream.begin(), current->upstream.end());
+    }
+    return false;
+}
+
+std::vector<ProbeDependencies::Node *> ProbeDependencies::dependents(Node &start) const
+{
+    std::vector<Node *> out;
+    std::vector<Node *> stack(start.downstream.begin(), start.downstream.end());
+    std::unordered_set<Node *> seen;
+    while (!stack.empty())
+    {
+        auto *current = stack.back();
+        stack.pop_back();
+        if (!seen.insert(current).second)
+            continue;
+        out.push_back(current);
+        stack.insert(stack.end(), current->downstream.begin(), current->downstream.end());
+    }
+    return out;
+}
+
+void ProbeDependencies::resume(std::vector<Node *> const &candidates)
+{
+    std::vector<std::string> names;
+    for (auto *candidate : candidates)
+    {
+        if (!candidate->blocked || blocker(*candidate))
+            continue;
+        candidate->blocked = false;
+        names.push_back(candidate->name);
+    }
+    for (auto const &name : names)
+    {
+        auto it = m_nodes.find(name);
+        if (it == m_nodes.end() || it->second.blocked)
+            continue;
+        ++m_stats.resumed;
+        if (it->second.change)
+            it->second.change(nullptr);
+    }
+}
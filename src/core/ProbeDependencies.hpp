@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Which probe targets can only be reached through another one, as a small
+// DAG keyed by scheduler target name ("internet", "boomlings",
+// "custom:<id>"). While an upstream target is down its dependents are not
+// probed at all: they are told right away that they are unreachable, and
+// told again as soon as every upstream they depend on is back, so they can
+// check at once instead of waiting for their next period. Main thread only.
+class ProbeDependencies
+{
+public:
+    // upstream is the name of the target that is down, or null when the
+    // target can be probed again
+    using Change = std::function<void(std::string const *upstream)>;
+
+    struct Stats
+    {
+        // checks skipped because an upstream was down
+        uint64_t skipped = 0;
+        // targets handed back after their upstream recovered
+        uint64_t resumed = 0;
+    };
+
+    static ProbeDependencies *get();
+
+    // Register a target (or replace its callback)
+    void add(std::string const &target, Change change);
+    // Drop a target and every edge to or from it; dependents it was
+    // holding back are resumed
+    void remove(std::string const &target);
+    // target is only reachable while upstream is. Unknown names are added
+    // without a callback. Returns false, changing nothing, when the edge
+    // would close a cycle.
+    bool depend(std::string const &target, std::string const &upstream);
+    void undepend(std::string const &target, std::string const &upstream);
+
+    // Result of the target's own check. A failure blocks every dependent
+    // that was not blocked yet; a recovery resumes the ones no other
+    // upstream still blocks.
+    void report(std::string const &target, bool up);
+    // Nearest upstream, direct or not, that is down; null when the target
+    // may be probed. Targets start out unknown, which does not block.
+    // A blocked target counts as skipped and is resumed later.
+    std::string const *skip(std::string const &target);
+
+    Stats const &stats() const { return m_stats; }
+
+private:
+    enum class State : uint8_t
+    {
+        Unknown,
+        Up,
+        Down,
+    };
+
+    struct Node
+    {
+        std::string name;
+        std::vector<Node *> upstream;
+        std::vector<Node *> downstream;
+        State state = State::Unknown;
+        // told it is unreachable and not resumed since
+        bool blocked = false;
+        Change change;
+    };
+
+    Node &node(std::string const &name);
+    Node const *blocker(Node const &node) const;
+    bool reaches(Node const &from, Node const &to) const;
+    // every target depending on node, directly or not
+    std::vector<Node *> dependents(Node &node) const;
+    void resume(std::vector<Node *> const &candidates);
+
+    // node addresses stay put when the map rehashes
+    std::unordered_map<std::string, Node> m_nodes;
+    Stats m_stats;
+};
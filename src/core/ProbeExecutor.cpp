@@ -0,0 +1,113 @@
+#include "ProbeExecutor.hpp"
+
+#include <algorithm>
+#include <memory>
+
+ProbeExecutor *ProbeExecutor::get()
+{
+    static ProbeExecutor instance;
+    return &instance;
+}
+
+void ProbeExecutor::submit(std::string_view host, ProbePriority priority, Job job)
+{
+    auto key = std::string(host);
+    auto &entry = m_hosts[key];
+    if (entry.name.empty())
+        entry.name = key;
+
+    auto prio = static_cast<size_t>(priority);
+    if (entry.queues[prio].empty())
+        m_ready[prio].push_back(key);
+    entry.queues[prio].push_back({std::move(job), Clock::now()});
+    ++m_stats.queued;
+    pump();
+}
+
+void ProbeExecutor::setLimits(size_t global, size_t perHost)
+{
+    m_maxGlobal = std::max<size_t>(global, 1);
+    m_maxPerHost = std::max<size_t>(perHost, 1);
+    pump();
+}
+
+bool ProbeExecutor::dispatchFrom(size_t prio)
+{
+    auto &ready = m_ready[prio];
+    // try every ready host once; ones at their limit rotate to the back
+    for (size_t tries = ready.size(); tries > 0; --tries)
+    {
+        auto name = std::move(ready.front());
+        ready.pop_front();
+        auto &host = m_hosts[name];
+        auto &queue = host.queues[prio];
+        if (queue.empty())
+            continue;
+        if (host.inFlight >= m_maxPerHost)
+        {
+            ready.push_back(std::move(name));
+            continue;
+        }
+
+        auto pending = std::move(queue.front());
+        queue.pop_front();
+        if (!queue.empty())
+            ready.push_back(name);
+
+        auto wait = Clock::now() - pending.enqueued;
+        m_stats.lastWait[prio] = wait;
+        m_stats.maxWait[prio] = std::max(m_stats.maxWait[prio], wait);
+        m_stats.avgWait[prio] = m_stats.avgWait[prio].count() == 0 ? wait : (m_stats.avgWait[prio] * 7 + wait) / 8;
+        ++m_stats.dispatched;
+        --m_stats.queued;
+
+        ++host.inFlight;
+        ++m_inFlight;
+        m_stats.inFlight = m_inFlight;
+
+        // guard against a job reporting completion twice
+        auto finished = std::make_shared<bool>(false);
+        pending.job([this, name, finished]() {
+            if (*finished)
+                return;
+            *finished = true;
+            this->finish(name);
+        });
+        return true;
+    }
+    return false;
+}
+
+void ProbeExecutor::pump()
+{
+    // jobs may complete synchronously and re-enter through finish()
+    if (m_pumping)
+        return;
+    m_pumping = true;
+    // the few built-in checks go past the global cap; they still count
+    // towards it, so custom probes wait until the total drops again
+    while (dispatchFrom(static_cast<size_t>(ProbePriority::High)))
+    {
+    }
+    while (m_inFlight < m_maxGlobal && dispatchFrom(static_cast<size_t>(ProbePriority::Normal)))
+    {
+    }
+    m_pumping = false;
+}
+
+void ProbeExecutor::finish(std::string const &name)
+{
+    if (auto it = m_hosts.find(name); it != m_hosts.end())
+    {
+        auto &host = it->second;
+        if (host.inFlight > 0)
+            --host.inFlight;
+        // forget idle hosts so the table only holds what is in use
+        if (host.inFlight == 0 && host.queues[0].empty() && host.queues[1].empty())
+            m_hosts.erase(it);
+    }
+    if (m_inFlight > 0)
+        --m_inFlight;
+    m_stats.inFlight = m_inFlight;
+    pump();
+}
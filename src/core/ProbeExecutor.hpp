@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+enum class ProbePriority : uint8_t
+{
+    // built-in services; dispatched before anything else and not held back
+    // by the global cap, only by the per-host one
+    High = 0,
+    // custom endpoints
+    Normal = 1,
+};
+
+// Admission control for outgoing probes. Caps the number of requests in
+// flight overall and per host, and dispatches queued probes by priority,
+// round-robin across hosts within a priority so one host with many custom
+// URLs cannot crowd out the rest. High priority probes only wait for their
+// own host, so custom endpoints filling the global cap never delay a
+// built-in check. Main thread only.
+class ProbeExecutor
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    // Must be called exactly once when the started request finished
+    using Done = std::function<void()>;
+    using Job = std::function<void(Done)>;
+
+    struct Stats
+    {
+        size_t queued = 0;
+        size_t inFlight = 0;
+        uint64_t dispatched = 0;
+        // time spent waiting for a slot, per priority
+        std::array<Clock::duration, 2> lastWait{};
+        std::array<Clock::duration, 2> avgWait{};
+        std::array<Clock::duration, 2> maxWait{};
+    };
+
+    static ProbeExecutor *get();
+
+    void submit(std::string_view host, ProbePriority priority, Job job);
+    void setLimits(size_t global, size_t perHost);
+
+    Stats const &stats() const { return m_stats; }
+
+private:
+    struct Pending
+    {
+        Job job;
+        Clock::time_point enqueued;
+    };
+
+    struct Host
+    {
+        std::string name;
+        size_t inFlight = 0;
+        // per priority FIFO
+        std::array<std::deque<Pending>, 2> queues;
+    };
+
+    void pump();
+    bool dispatchFrom(size_t priority);
+    void finish(std::string const &host);
+
+    std::unordered_map<std::string, Host> m_hosts;
+    // hosts with queued work, per priority, in round-robin order
+    std::array<std::deque<std::string>, 2> m_ready;
+    size_t m_maxGlobal = 6;
+    size_t m_maxPerHost = 2;
+    size_t m_inFlight = 0;
+    bool m_pumping = false;
+    Stats m_stats;
+};
@@ -0,0 +1,83 @@
+#include "ProbeRace.hpp"
+
+#include <utility>
+
+ProbeRace::ProbeRace(size_t targets, Clock::duration stagger, Clock::duration deadline, Start start, Cancel cancel, Done done)
+    : m_slots(targets, Slot::Waiting), m_stagger(stagger), m_deadline(deadline), m_start(std::move(start)),
+      m_cancel(std::move(cancel)), m_done(std::move(done))
+{
+}
+
+void ProbeRace::begin(Clock::time_point now)
+{
+    m_begun = now;
+    if (m_slots.empty())
+    {
+        finish({});
+        return;
+    }
+    startNext(now);
+}
+
+void ProbeRace::startNext(Clock::time_point now)
+{
+    auto index = m_next++;
+    m_slots[index] = Slot::Running;
+    ++m_running;
+    m_lastStart = now;
+    // may report synchronously, e.g. from a cached result
+    m_start(index);
+}
+
+void ProbeRace::report(size_t index, bool ok, int code, Clock::time_point now)
+{
+    if (m_finished || index >= m_slots.size() || m_slots[index] != Slot::Running)
+        return;
+    m_slots[index] = Slot::Failed;
+    --m_running;
+    if (code != 0)
+        m_lastCode = code;
+
+    if (ok)
+    {
+        finish({true, static_cast<int>(index), code, now - m_begun, m_next, false});
+        return;
+    }
+    // nothing left in flight: don't wait out the stagger
+    if (m_running == 0)
+    {
+        if (m_next < m_slots.size())
+            startNext(now);
+        else
+            finish({false, -1, m_lastCode, now - m_begun, m_next, false});
+    }
+}
+
+void ProbeRace::tick(Clock::time_point now)
+{
+    if (m_finished)
+        return;
+    if (now - m_begun >= m_deadline)
+    {
+        finish({false, -1, m_lastCode, now - m_begun, m_next, true});
+        return;
+    }
+    if (m_next < m_slots.size() && now - m_lastStart >= m_stagger)
+        startNext(now);
+}
+
+void ProbeRace::finish(Outcome outcome)
+{
+    m_finished = true;
+    for (size_t i = 0; i < m_slots.size(); ++i)
+    {
+        if (m_slots[i] == Slot::Running)
+        {
+            m_slots[i] = Slot::Failed;
+            m_cancel(i);
+        }
+    }
+    m_running = 0;
+    if (m_done)
+        m_done(outcome);
+}
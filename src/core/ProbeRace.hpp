@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Happy-eyeballs style race between equivalent probes, e.g. several hosts
+// that all prove the internet is reachable. Target 0 starts right away and
+// each further one after another stagger delay, or immediately once every
+// started target failed. The first success settles the race and cancels
+// the rest; it fails when every target failed or the deadline passed.
+// Main thread only; start may report back synchronously.
+class ProbeRace
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Outcome
+    {
+        bool ok = false;
+        // index of the target that answered, -1 when none did
+        int winner = -1;
+        int code = 0;
+        // from begin() to the decision
+        Clock::duration elapsed{};
+        size_t started = 0;
+        bool timedOut = false;
+    };
+
+    using Start = std::function<void(size_t index)>;
+    using Cancel = std::function<void(size_t index)>;
+    using Done = std::function<void(Outcome const &outcome)>;
+
+    ProbeRace(size_t targets, Clock::duration stagger, Clock::duration deadline, Start start, Cancel cancel, Done done);
+
+    void begin(Clock::time_point now = Clock::now());
+    // Result of a started target; late reports after the decision are ignored
+    void report(size_t index, bool ok, int code, Clock::time_point now = Clock::now());
+    // Start the next staggered target or give up at the deadline
+    void tick(Clock::time_point now = Clock::now());
+
+    bool finished() const { return m_finished; }
+
+private:
+    enum class Slot : unsigned char
+    {
+        Waiting,
+        Running,
+        Failed,
+    };
+
+    void startNext(Clock::time_point now);
+    void finish(Outcome outcome);
+
+    std::vector<Slot> m_slots;
+    Clock::duration m_stagger;
+    Clock::duration m_deadline;
+    Start m_start;
+    Cancel m_cancel;
+    Done m_done;
+    Clock::time_point m_begun{};
+    Clock::time_point m_lastStart{};
+    size_t m_next = 0;
+    size_t m_running = 0;
+    int m_lastCode = 0;
+    bool m_finished = false;
+};
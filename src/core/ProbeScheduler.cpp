@@ -0,0 +1,230 @@
+#include "ProbeScheduler.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+ProbeScheduler *ProbeScheduler::get()
+{
+    static ProbeScheduler instance;
+    return &instance;
+}
+
+ProbeScheduler::ProbeScheduler(Clock::time_point start)
+    : m_start(start), m_rng(std::random_device{}())
+{
+}
+
+uint64_t ProbeScheduler::toTicks(Clock::duration d) const
+{
+    auto ticks = std::chrono::ceil<std::chrono::milliseconds>(d) / kResolution;
+    return static_cast<uint64_t>(std::max<int64_t>(ticks, 1));
+}
+
+uint64_t ProbeScheduler::jittered(uint64_t interval)
+{
+    auto spread = static_cast<int64_t>(std::llround(interval * m_jitter / 2.0));
+    if (spread <= 0)
+        return interval;
+    std::uniform_int_distribution<int64_t> dist(-spread, spread);
+    return static_cast<uint64_t>(std::max<int64_t>(interval + dist(m_rng), 1));
+}
+
+ProbeScheduler::Timer *ProbeScheduler::lookup(Id id)
+{
+    if (id.index >= m_timers.size())
+        return nullptr;
+    auto &timer = m_timers[id.index];
+    if (!timer.alive || timer.generation != id.generation)
+        return nullptr;
+    return &timer;
+}
+
+ProbeScheduler::Timer const *ProbeScheduler::lookup(Id id) const
+{
+    return const_cast<ProbeScheduler *>(this)->lookup(id);
+}
+
+void ProbeScheduler::arm(Id id, uint64_t due)
+{
+    // the current slot was already processed
+    due = std::max(due, m_current + 1);
+    m_timers[id.index].due = due;
+    auto delta = due - m_current;
+    if (delta < kLevel0Size)
+        m_level0[due & (kLevel0Size - 1)].push_back({id, due});
+    else if (delta < kWheelSpan)
+        m_level1[(due >> kLevel0Bits) & (kLevel1Size - 1)].push_back({id, due});
+    else
+        m_overflow.push_back({id, due});
+}
+
+void ProbeScheduler::cascade(Bucket &bucket)
+{
+    Bucket moving;
+    moving.swap(bucket);
+    for (auto const &entry : moving)
+    {
+        auto timer = lookup(entry.id);
+        if (timer && timer->due == entry.due)
+            arm(entry.id, entry.due);
+    }
+}
+
+ProbeScheduler::Id ProbeScheduler::add(std::string name, Clock::duration interval, Callback fire)
+{
+    uint32_t index;
+    if (!m_free.empty())
+    {
+        index = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(m_timers.size());
+        m_timers.emplace_back();
+    }
+
+    auto &timer = m_timers[index];
+    timer.name = std::move(name);
+    timer.fire = std::move(fire);
+    timer.interval = toTicks(interval);
+    timer.alive = true;
+    timer.queued = false;
+    ++m_alive;
+
+    // golden ratio sequence: every new target lands in the largest gap left
+    // by the previous ones, so n targets end up roughly interval/n apart
+    constexpr double kGolden = 0.6180339887498949;
+    double phase = std::fmod(static_cast<double>(m_added++) * kGolden, 1.0);
+    auto offset = static_cast<uint64_t>(phase * timer.interval);
+
+    Id id{index, timer.generation};
+    arm(id, m_current + jittered(offset + 1));
+    return id;
+}
+
+void ProbeScheduler::remove(Id id)
+{
+    auto timer = lookup(id);
+    if (!timer)
+        return;
+    timer->alive = false;
+    timer->fire = nullptr;
+    timer->name.clear();
+    ++timer->generation;
+    --m_alive;
+    m_free.push_back(id.index);
+}
+
+bool ProbeScheduler::contains(Id id) const
+{
+    return lookup(id) != nullptr;
+}
+
+void ProbeScheduler::setInterval(Id id, Clock::duration interval)
+{
+    auto timer = lookup(id);
+    if (!timer)
+        return;
+    auto ticks = toTicks(interval);
+    if (ticks == timer->interval)
+        return;
+    timer->interval = ticks;
+    arm(id, m_current + jittered(ticks));
+}
+
+void ProbeScheduler::fireIn(Id id, Clock::duration delay)
+{
+    if (lookup(id))
+        arm(id, m_current + toTicks(delay));
+}
+
+void ProbeScheduler::fireSoon(Id id)
+{
+    if (lookup(id) && std::find(m_soon.begin(), m_soon.end(), id) == m_soon.end())
+        m_soon.push_back(id);
+}
+
+void ProbeScheduler::setJitter(float fraction)
+{
+    m_jitter = std::clamp(fraction, 0.f, 1.f);
+}
+
+void ProbeScheduler::tick(Clock::time_point now)
+{
+    if (now < m_start)
+        return;
+    auto target = static_cast<uint64_t>((now - m_start) / kResolution);
+
+    m_due.clear();
+    m_due.swap(m_soon);
+    for (auto const &id : m_due)
+    {
+        if (auto timer = lookup(id))
+            timer->queued = true;
+    }
+    while (m_current < target)
+    {
+        ++m_current;
+        auto slot = m_current & (kLevel0Size - 1);
+        if (slot == 0)
+        {
+            if (((m_current >> kLevel0Bits) & (kLevel1Size - 1)) == 0)
+                cascade(m_overflow);
+            cascade(m_level1[(m_current >> kLevel0Bits) & (kLevel1Size - 1)]);
+        }
+
+        auto &bucket = m_level0[slot];
+        for (size_t i = 0; i < bucket.size();)
+        {
+            auto entry = bucket[i];
+            auto timer = lookup(entry.id);
+            if (!timer || timer->due != entry.due)
+            {
+                bucket[i] = bucket.back();
+                bucket.pop_back();
+                continue;
+            }
+            if (entry.due > m_current)
+            {
+                ++i;
+                continue;
+            }
+            bucket[i] = bucket.back();
+            bucket.pop_back();
+            // a fireSoon() for it or an earlier period in this catch-up
+            // already put it in the list
+            if (!timer->queued)
+            {
+                timer->queued = true;
+                m_due.push_back(entry.id);
+            }
+
+            // lag is measured against the tick the timer was armed for
+            auto scheduled = m_start + kResolution * static_cast<int64_t>(entry.due);
+            Clock::duration lag = now - scheduled;
+            m_stats.lastLag = lag;
+            m_stats.maxLag = std::max(m_stats.maxLag, lag);
+            m_stats.avgLag = m_stats.fired == 0 ? lag : (m_stats.avgLag * 7 + lag) / 8;
+            ++m_stats.fired;
+
+            arm(entry.id, m_current + jittered(timer->interval));
+        }
+    }
+    m_stats.queueDepth = m_alive;
+
+    // callbacks run after the wheel is consistent, so they may freely add,
+    // remove or reschedule timers (including themselves)
+    for (auto const &id : m_due)
+    {
+        auto timer = lookup(id);
+        if (!timer)
+            continue;
+        timer->queued = false;
+        if (timer->fire)
+        {
+            auto fire = timer->fire;
+            fire();
+        }
+    }
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+// Central scheduler for every periodic probe (built-in services and custom
+// nodes). Timers live in a two-level hashed timer wheel so adding, removing
+// and advancing are O(1) per timer regardless of how many targets exist.
+// New targets get a start phase spread across their interval and every
+// period is jittered so probes never line up into bursts.
+class ProbeScheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Callback = std::function<void()>;
+
+    struct Id
+    {
+        uint32_t index = UINT32_MAX;
+        uint32_t generation = 0;
+
+        bool valid() const { return index != UINT32_MAX; }
+        bool operator==(Id const &) const = default;
+    };
+
+    struct Stats
+    {
+        // timers currently armed in the wheel
+        size_t queueDepth = 0;
+        // difference between the scheduled and the actual fire time
+        Clock::duration lastLag{};
+        Clock::duration maxLag{};
+        Clock::duration avgLag{};
+        uint64_t fired = 0;
+    };
+
+    static constexpr auto kResolution = std::chrono::milliseconds(100);
+
+    static ProbeScheduler *get();
+    static Clock::duration fromSeconds(float seconds)
+    {
+        return std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(seconds));
+    }
+
+    explicit ProbeScheduler(Clock::time_point start = Clock::now());
+
+    // Register a periodic target. The first fire lands somewhere inside the
+    // first interval, chosen so consecutive targets are evenly spread.
+    Id add(std::string name, Clock::duration interval, Callback fire);
+    void remove(Id id);
+    bool contains(Id id) const;
+    // Change the period; the next fire is rescheduled relative to now
+    void setInterval(Id id, Clock::duration interval);
+    // Move the next fire to `delay` from now (no jitter added); the
+    // periodic interval resumes after it
+    void fireIn(Id id, Clock::duration delay);
+    // Fire once on the next tick without disturbing the periodic phase
+    void fireSoon(Id id);
+    // Fraction of the interval used as +-jitter on every period (0..1)
+    void setJitter(float fraction);
+
+    // Advance the wheel to `now`, firing every timer that came due (or was
+    // asked to fire soon) once, however many of its periods passed
+    void tick(Clock::time_point now = Clock::now());
+
+    Stats const &stats() const { return m_stats; }
+
+private:
+    static constexpr uint32_t kLevel0Bits = 8;
+    static constexpr uint32_t kLevel1Bits = 6;
+    static constexpr uint64_t kLevel0Size = 1ull << kLevel0Bits;
+    static constexpr uint64_t kLevel1Size = 1ull << kLevel1Bits;
+    static constexpr uint64_t kWheelSpan = kLevel0Size * kLevel1Size;
+
+    struct Timer
+    {
+        std::string name;
+        Callback fire;
+        uint64_t interval = 0;
+        uint64_t due = 0;
+        uint32_t generation = 0;
+        bool alive = false;
+        // already in the fire list of the current tick
+        bool queued = false;
+    };
+
+    // Wheel entries carry the due tick they were armed for; entries whose
+    // timer was removed or rescheduled since are skipped lazily.
+    struct Entry
+    {
+        Id id;
+        uint64_t due = 0;
+    };
+    using Bucket = std::vector<Entry>;
+
+    Timer *lookup(Id id);
+    Timer const *lookup(Id id) const;
+    void arm(Id id, uint64_t due);
+    void cascade(Bucket &bucket);
+    uint64_t toTicks(Clock::duration d) const;
+    uint64_t jittered(uint64_t interval);
+
+    Clock::time_point m_start;
+    uint64_t m_current = 0;
+    std::array<Bucket, kLevel0Size> m_level0;
+    std::array<Bucket, kLevel1Size> m_level1;
+    Bucket m_overflow;
+
+    std::vector<Timer> m_timers;
+    std::vector<uint32_t> m_free;
+    size_t m_alive = 0;
+    uint64_t m_added = 0;
+
+    float m_jitter = 0.1f;
+    std::minstd_rand m_rng;
+    Stats m_stats;
+    std::vector<Id> m_due;
+    std::vector<Id> m_soon;
+};
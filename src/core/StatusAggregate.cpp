@@ -0,0 +1,15 @@
+#include "StatusAggregate.hpp"
+
+StatusAggregate aggregateStatus(std::span<bool const> up)
+{
+    if (up.empty())
+        return StatusAggregate::Unknown;
+    size_t online = 0;
+    for (bool ok : up)
+        online += ok;
+    if (online == up.size())
+        return StatusAggregate::AllUp;
+    if (online == 0)
+        return StatusAggregate::AllDown;
+    return StatusAggregate::Partial;
+}
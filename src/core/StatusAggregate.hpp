@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+// Overall state shown by the status icon
+enum class StatusAggregate : uint8_t
+{
+    // nothing to report on
+    Unknown,
+    AllUp,
+    // some services down
+    Partial,
+    AllDown,
+};
+
+StatusAggregate aggregateStatus(std::span<bool const> up);
@@ -0,0 +1,93 @@
+#include "StatusBus.hpp"
+
+#include <algorithm>
+#include <utility>
+
+StatusBus::Subscription::Subscription(Subscription &&other) noexcept
+    : m_id(std::exchange(other.m_id, 0))
+{
+}
+
+StatusBus::Subscription &StatusBus::Subscription::operator=(Subscription &&other) noexcept
+{
+    if (this != &other)
+    {
+        reset();
+        m_id = std::exchange(other.m_id, 0);
+    }
+    return *this;
+}
+
+void StatusBus::Subscription::reset()
+{
+    if (m_id)
+        StatusBus::get()->unsubscribe(m_id);
+    m_id = 0;
+}
+
+uint64_t StatusBus::Subscription::release()
+{
+    return std::exchange(m_id, 0);
+}
+
+StatusBus *StatusBus::get()
+{
+    static StatusBus instance;
+    return &instance;
+}
+
+void StatusBus::publish(ServiceState state)
+{
+    bool changed = true;
+    auto it = std::find_if(m_states.begin(), m_states.end(), [&](ServiceState const &s)
+                           { return s.service == state.service; });
+    if (it == m_states.end())
+    {
+        it = m_states.insert(m_states.end(), std::move(state));
+    }
+    else
+    {
+        changed = it->online != state.online || it->restored != state.restored;
+        *it = std::move(state);
+    }
+
+    // callbacks may subscribe or unsubscribe; work on a copy
+    auto subscribers = m_subscribers;
+    auto const current = *it;
+    for (auto const &[id, callback] : subscribers)
+    {
+        bool alive = std::any_of(m_subscribers.begin(), m_subscribers.end(), [id](auto const &s)
+                                 { return s.first == id; });
+        if (alive)
+            callback(current, changed);
+    }
+}
+
+StatusBus::Subscription StatusBus::subscribe(Callback callback)
+{
+    auto id = m_nextId++;
+    m_subscribers.emplace_back(id, std::move(callback));
+    return Subscription(id);
+}
+
+void StatusBus::unsubscribe(uint64_t id)
+{
+    std::erase_if(m_subscribers, [id](auto const &s)
+                  { return s.first == id; });
+}
+
+ServiceState const *StatusBus::find(std::string_view service) const
+{
+    for (auto const &state : m_states)
+    {
+        if (state.service == service)
+            return &state;
+    }
+    return nullptr;
+}
+
+void StatusBus::requestRefresh()
+{
+    if (m_refresh)
+        m_refresh();
+}
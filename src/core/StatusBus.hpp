@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "LatencyHistogram.hpp"
+#include "Timestamp.hpp"
+
+// Latest result of a built-in service check
+struct ServiceState
+{
+    // "internet", "boomlings", "geode" or "argon"
+    std::string service;
+    bool online = false;
+    int code = 0;
+    // URL that was checked; for the internet, the target that answered
+    // first
+    std::string target;
+    LatencyHistogram::Summary latency;
+    EpochTime lastOk;
+    EpochTime checkedAt;
+    // set when the service was not checked because this upstream target
+    // ("internet") is down
+    std::string upstream;
+    // carried over from the last session at startup; not checked yet
+    bool restored = false;
+};
+
+// Process-wide view of the built-in services. StatusMonitor is the only
+// prober and publishes every finished check here; the status popup and
+// other mods read the snapshot and subscribe instead of probing on their
+// own. Main thread only.
+class StatusBus
+{
+public:
+    // changed is set when the service went up or down (or was checked for
+    // the first time, restored states included)
+    using Callback = std::function<void(ServiceState const &state, bool changed)>;
+
+    // Unsubscribes when destroyed
+    class Subscription
+    {
+        friend class StatusBus;
+        uint64_t m_id = 0;
+
+        explicit Subscription(uint64_t id) : m_id(id) {}
+
+    public:
+        Subscription() = default;
+        Subscription(Subscription const &) = delete;
+        Subscription &operator=(Subscription const &) = delete;
+        Subscription(Subscription &&other) noexcept;
+        Subscription &operator=(Subscription &&other) noexcept;
+        ~Subscription() { reset(); }
+
+        void reset();
+        // Hand the subscription over to the bus; it lasts for the process
+        uint64_t release();
+    };
+
+    static StatusBus *get();
+
+    void publish(ServiceState state);
+    [[nodiscard]] Subscription subscribe(Callback callback);
+    void unsubscribe(uint64_t id);
+
+    // null before the service was checked
+    ServiceState const *find(std::string_view service) const;
+    std::vector<ServiceState> const &snapshot() const { return m_states; }
+
+    // Ask the prober to check everything now
+    void setRefreshHandler(std::function<void()> handler) { m_refresh = std::move(handler); }
+    void requestRefresh();
+
+private:
+    std::vector<ServiceState> m_states;
+    std::vector<std::pair<uint64_t, Callback>> m_subscribers;
+    std::function<void()> m_refresh;
+    uint64_t m_nextId = 1;
+};
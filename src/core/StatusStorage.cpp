@@ -0,0 +1,567 @@
+#include "StatusStorage.hpp"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+#include "CoreLog.hpp"
+#include "IoWorker.hpp"
+#include "StorageJournal.hpp"
+#include "Timestamp.hpp"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    // journal bytes after which the next flush folds it into a new snapshot
+    constexpr size_t kCompactThreshold = 64 * 1024;
+    // ping times that moved without a state change are written with a
+    // snapshot at most this much later (or on a forced flush)
+    constexpr auto kPingPersistInterval = std::chrono::minutes(10);
+    constexpr uint32_t kNoKey = UINT32_MAX;
+
+    // Journal state shared with the I/O worker. The main thread buffers
+    // records here; the appender is only touched by worker jobs.
+    struct Journal
+    {
+        std::mutex mutex;
+        std::vector<StorageJournal::Record> records;
+        // generation the buffered records belong to
+        uint32_t generation = 0;
+        StorageJournal::Appender appender;
+    };
+
+    struct LoadedStore
+    {
+        NodeRegistry nodes;
+        std::vector<uint32_t> keys;
+        uint32_t nextKey = 0;
+        uint32_t generation = 0;
+        size_t journalBytes = 0;
+        // needs a new snapshot (migration or unfinished compaction)
+        bool dirty = false;
+    };
+
+    struct Store
+    {
+        NodeRegistry nodes;
+        // journal key per registry slot
+        std::vector<uint32_t> keys;
+        uint32_t nextKey = 0;
+        // number of stored nodes that are offline, so allOnline() is O(1)
+        size_t offline = 0;
+        bool loaded = false;
+        // something changed that only a new snapshot can record
+        bool dirty = false;
+        // a ping time changed in memory only, since this time
+        bool pingsPending = false;
+        Clock::time_point pingsSince{};
+        Clock::time_point lastFlush{};
+        Clock::duration window = std::chrono::seconds(5);
+
+        uint32_t generation = 0;
+        // journal bytes recorded since the last snapshot
+        size_t journalBytes = 0;
+        // records were buffered since the last drain was queued
+        bool unsent = false;
+        // a snapshot is queued or being written
+        bool compacting = false;
+        std::shared_ptr<Journal> journal = std::make_shared<Journal>();
+        // result of preload(), filled in by the I/O worker
+        std::shared_ptr<LoadedStore> preload;
+
+        std::filesystem::path directory = ".";
+        StatusStorage::LegacyReader legacyReader;
+    };
+
+    static Store &store()
+    {
+        static Store s;
+        return s;
+    }
+
+    static std::filesystem::path snapshotPath()
+    {
+        return store().directory / "status.bin";
+    }
+
+    static std::filesystem::path legacyPath()
+    {
+        return store().directory / "status.json";
+    }
+
+    static std::vector<uint8_t> readFile(std::filesystem::path const &path)
+    {
+        std::ifstream in(path, std::ios::binary);
+        if (!in)
+            return {};
+        return std::vector<uint8_t>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // Delete the journals of generations older than keep (all of them when
+    // keep is 0), left behind by compactions or crashes
+    static void removeStaleJournals(std::filesystem::path const &snapshot, uint32_t keep)
+    {
+        auto prefix = snapshot.filename().string() + ".";
+        std::error_code ec;
+        for (auto const &entry : std::filesystem::directory_iterator(snapshot.parent_path(), ec))
+        {
+            auto name = entry.path().filename().string();
+            if (!name.starts_with(prefix) || !name.ends_with(".journal"))
+                continue;
+            auto gen = std::strtoul(name.c_str() + prefix.size(), nullptr, 10);
+            if (keep == 0 || gen < keep)
+                std::filesystem::remove(entry.path(), ec);
+        }
+    }
+
+    static bool writeSnapshot(std::filesystem::path const &path, std::vector<uint8_t> const &bytes)
+    {
+        // write next to the real file, then swap it in so a crash mid-write
+        // never leaves a truncated snapshot behind
+        auto tmp = path;
+        tmp += ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<char const *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            if (!out.flush())
+            {
+                CoreLog::error("Failed to write {}", tmp.string());
+                return false;
+            }
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+        if (ec)
+        {
+            CoreLog::error("Failed to replace {}: {}", path.string(), ec.message());
+            return false;
+        }
+        return true;
+    }
+
+    static uint32_t &keyOf(std::vector<uint32_t> &keys, NodeHandle handle)
+    {
+        if (keys.size() <= handle.index)
+            keys.resize(handle.index + 1, kNoKey);
+        return keys[handle.index];
+    }
+
+    static uint32_t &keyOf(Store &s, NodeHandle handle)
+    {
+        return keyOf(s.keys, handle);
+    }
+
+    // Hand the records buffered since the last call to the I/O worker. A
+    // drain that has not started yet simply picks the new ones up too.
+    static void drainJournal(Store &s)
+    {
+        if (!s.unsent)
+            return;
+        s.unsent = false;
+        auto path = snapshotPath();
+        IoWorker::get()->submit(
+            StorageJournal::journalPath(path, 0).string(),
+            [journal = s.journal, path]() {
+                std::vector<StorageJournal::Record> records;
+                uint32_t generation = 0;
+                {
+                    std::lock_guard lock(journal->mutex);
+                    records.swap(journal->records);
+                    generation = journal->generation;
+                }
+                if (records.empty())
+                    return true;
+                auto &appender = journal->appender;
+                if (!appender.isOpen() || appender.generation() != generation)
+                {
+                    if (!appender.open(StorageJournal::journalPath(path, generation), generation))
+                        return false;
+                }
+                return appender.append(records);
+            },
+            [](bool ok) {
+                // fall back to a snapshot if the journal is unavailable
+                if (!ok)
+                    store().dirty = true;
+            });
+    }
+
+    // Start a new generation: the current state becomes its snapshot and
+    // further appends go to its (empty) journal. The files are written by
+    // the I/O worker; retireLegacy renames status.json once the snapshot
+    // has landed.
+    static void compact(Store &s, bool retireLegacy = false)
+    {
+        auto path = snapshotPath();
+        StorageJournal::SnapshotInfo info{s.generation + 1, s.nextKey};
+        auto bytes = StorageJournal::encodeSnapshot(info, s.nodes, s.keys);
+
+        // the snapshot covers everything buffered so far, but it is not on
+        // disk yet: those records still go to the old generation's journal,
+        // which is only deleted once the snapshot landed. Later records
+        // belong to the new generation.
+        std::vector<StorageJournal::Record> retiring;
+        {
+            std::lock_guard lock(s.journal->mutex);
+            retiring.swap(s.journal->records);
+            s.journal->generation = info.generation;
+        }
+        s.generation = info.generation;
+        s.journalBytes = 0;
+        s.dirty = false;
+        s.pingsPending = false;
+        s.compacting = true;
+
+        // until the snapshot lands, recovery replays the old journal followed
+        // by the new one, so nothing is lost if we die in between
+        auto job = [journal = s.journal, path, bytes = std::move(bytes), gen = info.generation,
+                    retiring = std::move(retiring), legacy = retireLegacy ? legacyPath() : std::filesystem::path()]() {
+            auto &appender = journal->appender;
+            if (!retiring.empty())
+            {
+                auto old = gen - 1;
+                bool open = appender.isOpen() && appender.generation() == old;
+                if (!open)
+                    open = appender.open(StorageJournal::journalPath(path, old), old);
+                // the snapshot below still records them if this fails
+                if (!open || !appender.append(retiring))
+                    CoreLog::error("Failed to journal {} records for generation {}", retiring.size(), old);
+            }
+            if (!appender.isOpen() || appender.generation() != gen)
+            {
+                if (!appender.open(StorageJournal::journalPath(path, gen), gen))
+                {
+                    CoreLog::error("Failed to open journal for generation {}", gen);
+                    return false;
+                }
+            }
+            if (!writeSnapshot(path, bytes))
+                return false;
+            removeStaleJournals(path, gen);
+
+            std::error_code ec;
+            if (!legacy.empty() && std::filesystem::exists(legacy, ec))
+            {
+                auto backup = legacy;
+                backup += ".bak";
+                std::filesystem::rename(legacy, backup, ec);
+            }
+            return true;
+        };
+        IoWorker::get()->submit(path.string(), std::move(job), [](bool ok) {
+            auto &s = store();
+            s.compacting = false;
+            // a failed snapshot leaves the old generation readable; try again
+            if (!ok)
+                s.dirty = true;
+        });
+    }
+
+    // Read the snapshot and journals (or migrate status.json). Touches no
+    // shared state, so it can run on the I/O worker.
+    static LoadedStore readStore(std::filesystem::path const &directory, StatusStorage::LegacyReader const &legacyReader)
+    {
+        LoadedStore out;
+        auto path = directory / "status.bin";
+        auto data = readFile(path);
+        auto info = data.empty() ? std::nullopt : StorageJournal::decodeSnapshot(data, out.nodes, out.keys);
+        if (!data.empty() && !info)
+        {
+            CoreLog::error("{} is corrupt, starting with an empty store", path.string());
+            out.nodes.clear();
+            out.keys.clear();
+        }
+
+        if (info)
+        {
+            out.generation = info->generation;
+            out.nextKey = info->nextKey;
+
+            std::unordered_map<uint32_t, NodeHandle> byKey;
+            byKey.reserve(out.nodes.size());
+            for (auto it = out.nodes.begin(); it != out.nodes.end(); ++it)
+                byKey.emplace(keyOf(out.keys, it.handle()), it.handle());
+
+            auto apply = [&](StorageJournal::Record const &record) {
+                auto it = byKey.find(record.key);
+                if (it == byKey.end())
+                    return;
+                if (auto node = out.nodes.get(it->second))
+                {
+                    node->online = record.online;
+                    node->last_ping = EpochTime{record.timestamp};
+                }
+            };
+            auto gen = out.generation;
+            StorageJournal::replay(StorageJournal::journalPath(path, gen), gen, apply);
+            // a compaction that never finished leaves newer journals behind;
+            // fold them into a fresh snapshot once adopted
+            while (StorageJournal::replay(StorageJournal::journalPath(path, gen + 1), gen + 1, apply))
+                ++gen;
+            removeStaleJournals(path, out.generation);
+            std::error_code ec;
+            auto size = std::filesystem::file_size(StorageJournal::journalPath(path, gen), ec);
+            out.journalBytes = ec || size < StorageJournal::kHeaderSize ? 0 : size - StorageJournal::kHeaderSize;
+            if (gen != out.generation)
+            {
+                out.generation = gen;
+                out.dirty = true;
+            }
+        }
+        else
+        {
+            removeStaleJournals(path, 0);
+            // one-time migration from status.json
+            std::error_code ec;
+            auto legacy = directory / "status.json";
+            if (legacyReader && std::filesystem::exists(legacy, ec) && legacyReader(legacy, out.nodes))
+            {
+                for (auto it = out.nodes.begin(); it != out.nodes.end(); ++it)
+                    keyOf(out.keys, it.handle()) = out.nextKey++;
+                CoreLog::info("Migrating {} custom statuses to {}", out.nodes.size(), path.string());
+                out.dirty = true;
+            }
+        }
+        return out;
+    }
+
+    static void adopt(Store &s, LoadedStore loaded)
+    {
+        s.nodes = std::move(loaded.nodes);
+        s.keys = std::move(loaded.keys);
+        s.nextKey = loaded.nextKey;
+        s.generation = loaded.generation;
+        s.journalBytes = loaded.journalBytes;
+        {
+            std::lock_guard lock(s.journal->mutex);
+            s.journal->generation = s.generation;
+        }
+
+        s.offline = 0;
+        for (auto it = s.nodes.begin(); it != s.nodes.end(); ++it)
+        {
+            auto node = s.nodes.get(it.handle());
+            if (!node->online)
+                ++s.offline;
+        }
+
+        if (loaded.dirty)
+            compact(s, true);
+    }
+
+    // Finish pending writes and forget everything loaded
+    static void unload(Store &s)
+    {
+        auto worker = IoWorker::get();
+        // a pending preload is dropped, not adopted by the poll below
+        s.preload.reset();
+        worker->wait();
+        worker->poll();
+        s.journal = std::make_shared<Journal>();
+        s.nodes.clear();
+        s.keys.clear();
+        s.nextKey = 0;
+        s.offline = 0;
+        s.generation = 0;
+        s.journalBytes = 0;
+        s.unsent = false;
+        s.compacting = false;
+        s.dirty = false;
+        s.pingsPending = false;
+        s.loaded = false;
+    }
+
+    static Store &loaded()
+    {
+        auto &s = store();
+        if (!s.loaded)
+        {
+            s.loaded = true;
+            if (s.preload)
+            {
+                // still reading in the background; this is the one place
+                // the main thread waits for the disk
+                IoWorker::get()->wait();
+                auto preload = std::move(s.preload);
+                adopt(s, std::move(*preload));
+            }
+            else
+            {
+                adopt(s, readStore(s.directory, s.legacyReader));
+            }
+        }
+        return s;
+    }
+}
+
+NodeRegistry const &StatusStorage::nodes()
+{
+    return loaded().nodes;
+}
+
+void StatusStorage::setDirectory(std::filesystem::path directory)
+{
+    auto &s = store();
+    if (s.loaded)
+        flush(true);
+    if (s.loaded || s.preload)
+        unload(s);
+    s.directory = std::move(directory);
+}
+
+void StatusStorage::preload()
+{
+    auto &s = store();
+    if (s.loaded || s.preload)
+        return;
+    auto result = std::make_shared<LoadedStore>();
+    s.preload = result;
+    IoWorker::get()->submit(
+        [result, directory = s.directory, reader = s.legacyReader]() {
+            *result = readStore(directory, reader);
+            return true;
+        },
+        [result](bool) {
+            // adopt it right away unless an access already did, or the
+            // directory changed meanwhile
+            if (store().preload == result)
+                loaded();
+        });
+}
+
+void StatusStorage::setLegacyReader(LegacyReader reader)
+{
+    store().legacyReader = std::move(reader);
+}
+
+NodeHandle StatusStorage::find(std::string const &id)
+{
+    return loaded().nodes.find(id);
+}
+
+StoredNode const *StatusStorage::get(NodeHandle handle)
+{
+    return loaded().nodes.get(handle);
+}
+
+NodeHandle StatusStorage::upsertNode(StoredNode const &node)
+{
+    auto &s = loaded();
+    auto existing = s.nodes.find(node.id);
+    if (auto ex = s.nodes.get(existing); ex && !ex->online)
+        --s.offline;
+    if (!node.online)
+        ++s.offline;
+    s.dirty = true;
+
+    auto handle = s.nodes.upsert(node);
+    if (!existing.valid())
+        keyOf(s, handle) = s.nextKey++;
+    return handle;
+}
+
+void StatusStorage::remove(NodeHandle handle)
+{
+    auto &s = loaded();
+    auto ex = s.nodes.get(handle);
+    if (!ex)
+        return;
+    if (!ex->online)
+        --s.offline;
+    s.nodes.erase(handle);
+    keyOf(s, handle) = kNoKey;
+    s.dirty = true;
+}
+
+void StatusStorage::removeById(std::string const &id)
+{
+    remove(find(id));
+}
+
+bool StatusStorage::setState(NodeHandle handle, bool online, EpochTime lastPing)
+{
+    auto &s = loaded();
+    auto node = s.nodes.get(handle);
+    if (!node)
+        return false;
+    if (node->online == online && node->last_ping == lastPing)
+        return false;
+    bool flipped = node->online != online;
+    if (node->online && !online)
+        ++s.offline;
+    else if (!node->online && online)
+        --s.offline;
+    node->online = online;
+    node->last_ping = lastPing;
+
+    // a healthy node pings on every check; only the snapshot records that
+    if (!flipped)
+    {
+        if (!s.pingsPending)
+            s.pingsSince = Clock::now();
+        s.pingsPending = true;
+        return true;
+    }
+
+    // buffered here, appended by the I/O worker on the next flush()
+    {
+        std::lock_guard lock(s.journal->mutex);
+        s.journal->records.push_back({keyOf(s, handle), online, lastPing.seconds});
+    }
+    s.journalBytes += StorageJournal::kRecordSize;
+    s.unsent = true;
+    return true;
+}
+
+bool StatusStorage::allOnline()
+{
+    return loaded().offline == 0;
+}
+
+void StatusStorage::flush(bool force)
+{
+    auto &s = store();
+    if (!s.loaded)
+        return;
+
+    drainJournal(s);
+    auto worker = IoWorker::get();
+    if (force)
+    {
+        // let a running snapshot finish so its outcome is known
+        worker->wait();
+        worker->poll();
+    }
+
+    if (s.pingsPending && (force || Clock::now() - s.pingsSince >= kPingPersistInterval))
+        s.dirty = true;
+    if (!s.compacting && (s.dirty || s.journalBytes >= kCompactThreshold))
+    {
+        auto now = Clock::now();
+        if (force || now - s.lastFlush >= s.window)
+        {
+            compact(s);
+            s.lastFlush = now;
+        }
+    }
+
+    if (force)
+    {
+        worker->wait();
+        worker->poll();
+    }
+}
+
+void StatusStorage::setFlushWindow(float seconds)
+{
+    store().window = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<float>(std::max(seconds, 0.f)));
+}
+
+bool StatusStorage::isDirty()
+{
+    return store().dirty;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <string>
+
+#include "NodeRegistry.hpp"
+
+namespace StatusStorage
+{
+    // Process-wide node list, loaded from the snapshot + journal on first
+    // access (migrating status.json once if there is no snapshot yet).
+    // All file I/O runs on the IoWorker thread: state changes are buffered
+    // and appended to the journal on the next flush(); definition changes
+    // only touch memory until flush() writes a new snapshot.
+    NodeRegistry const &nodes();
+
+    // Directory holding the snapshot and journals, normally the mod's save
+    // directory. Set it before first use; changing it later flushes and
+    // drops whatever was loaded, so the next access loads from the new one.
+    void setDirectory(std::filesystem::path directory);
+    // Parses a status.json from before the journal format into the registry,
+    // returning false when there was nothing to import
+    using LegacyReader = std::function<bool(std::filesystem::path const &, NodeRegistry &)>;
+    void setLegacyReader(LegacyReader reader);
+    // Start loading on the I/O worker, after setDirectory/setLegacyReader.
+    // The store is adopted on the IoWorker poll that follows; an earlier
+    // access waits for the read instead of doing it again.
+    void preload();
+
+    // Handles stay valid until the node is removed; lookups through them
+    // are O(1) and never copy the node
+    NodeHandle find(std::string const &id);
+    StoredNode const *get(NodeHandle handle);
+    NodeHandle upsertNode(StoredNode const &node);
+    void remove(NodeHandle handle);
+    void removeById(std::string const &id);
+    // Update the probe state of a node. Going online or offline costs one
+    // buffered fixed-size journal record; a newer ping time alone stays in
+    // memory and is written with a snapshot within ten minutes, or by a
+    // forced flush. Returns false when the handle is stale or neither
+    // online nor the ping time changed.
+    bool setState(NodeHandle handle, bool online, EpochTime lastPing);
+    // true when every stored node is online (or there are none)
+    bool allOnline();
+
+    // Queue buffered journal records, and a new snapshot if definitions
+    // changed or the journal outgrew its threshold, at most once per flush
+    // window. With force the snapshot ignores the window and the call waits
+    // until the worker wrote everything. Call it every tick after polling
+    // the IoWorker.
+    void flush(bool force = false);
+    void setFlushWindow(float seconds);
+    bool isDirty();
+}
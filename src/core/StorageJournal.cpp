@@ -0,0 +1,290 @@
+#include "StorageJournal.hpp"
+
+#include <array>
+#include <string>
+#include <string_view>
+
+namespace
+{
+    constexpr uint32_t kSnapshotMagic = 0x504e5353; // "SSNP"
+    constexpr uint32_t kJournalMagic = 0x4c4a5353;  // "SSJL"
+    constexpr uint32_t kVersion = 1;
+    // 2 appended depends_on to every node; journals stay at kVersion
+    constexpr uint32_t kSnapshotVersion = 2;
+
+    uint32_t checksum(uint8_t const *data, size_t size)
+    {
+        // FNV-1a, only needs to catch torn and garbage writes
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < size; ++i)
+        {
+            hash ^= data[i];
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    // little-endian regardless of the platform, so saves move between devices
+    void put(uint8_t *out, uint64_t value, size_t bytes)
+    {
+        for (size_t i = 0; i < bytes; ++i)
+            out[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+
+    uint64_t take(uint8_t const *in, size_t bytes)
+    {
+        uint64_t value = 0;
+        for (size_t i = 0; i < bytes; ++i)
+            value |= static_cast<uint64_t>(in[i]) << (8 * i);
+        return value;
+    }
+
+    struct Writer
+    {
+        std::vector<uint8_t> &out;
+
+        void u8(uint8_t v) { out.push_back(v); }
+        void u32(uint32_t v)
+        {
+            out.resize(out.size() + 4);
+            put(out.data() + out.size() - 4, v, 4);
+        }
+        void i64(int64_t v)
+        {
+            out.resize(out.size() + 8);
+            put(out.data() + out.size() - 8, static_cast<uint64_t>(v), 8);
+        }
+        void str(std::string const &s)
+        {
+            u32(static_cast<uint32_t>(s.size()));
+            out.insert(out.end(), s.begin(), s.end());
+        }
+    };
+
+    struct Reader
+    {
+        std::span<uint8_t const> in;
+        size_t pos = 0;
+        bool ok = true;
+
+        bool need(size_t bytes)
+        {
+            if (pos + bytes > in.size())
+                ok = false;
+            return ok;
+        }
+        uint8_t u8()
+        {
+            if (!need(1))
+                return 0;
+            return in[pos++];
+        }
+        uint32_t u32()
+        {
+            if (!need(4))
+                return 0;
+            pos += 4;
+            return static_cast<uint32_t>(take(in.data() + pos - 4, 4));
+        }
+        int64_t i64()
+        {
+            if (!need(8))
+                return 0;
+            pos += 8;
+            return static_cast<int64_t>(take(in.data() + pos - 8, 8));
+        }
+        std::string str()
+        {
+            auto size = u32();
+            if (!need(size))
+                return {};
+            pos += size;
+            return std::string(reinterpret_cast<char const *>(in.data() + pos - size), size);
+        }
+    };
+
+    std::array<uint8_t, StorageJournal::kHeaderSize> journalHeader(uint32_t generation)
+    {
+        std::array<uint8_t, StorageJournal::kHeaderSize> header{};
+        put(header.data(), kJournalMagic, 4);
+        put(header.data() + 4, kVersion, 4);
+        put(header.data() + 8, generation, 4);
+        return header;
+    }
+
+    std::array<uint8_t, StorageJournal::kRecordSize> encodeRecord(StorageJournal::Record const &record, uint32_t generation)
+    {
+        std::array<uint8_t, StorageJournal::kRecordSize> bytes{};
+        put(bytes.data(), record.key, 4);
+        put(bytes.data() + 4, record.online ? 1 : 0, 4);
+        put(bytes.data() + 8, static_cast<uint64_t>(record.timestamp), 8);
+        put(bytes.data() + 16, generation, 4);
+        put(bytes.data() + 20, checksum(bytes.data(), 20), 4);
+        return bytes;
+    }
+}
+
+std::filesystem::path StorageJournal::journalPath(std::filesystem::path const &snapshot, uint32_t generation)
+{
+    auto path = snapshot;
+    path += "." + std::to_string(generation) + ".journal";
+    return path;
+}
+
+std::vector<uint8_t> StorageJournal::encodeSnapshot(SnapshotInfo const &info, NodeRegistry const &nodes, std::span<uint32_t const> keys)
+{
+    std::vector<uint8_t> out;
+    out.reserve(20 + nodes.size() * 100);
+    Writer w{out};
+    w.u32(kSnapshotMagic);
+    w.u32(kSnapshotVersion);
+    w.u32(info.generation);
+    w.u32(info.nextKey);
+    w.u32(static_cast<uint32_t>(nodes.size()));
+    for (auto it = nodes.begin(); it != nodes.end(); ++it)
+    {
+        auto const &n = *it;
+        auto index = it.handle().index;
+        w.u32(index < keys.size() ? keys[index] : info.nextKey);
+        w.str(n.id);
+        w.str(n.name);
+        w.str(n.url);
+        w.u8(n.online ? 1 : 0);
+        w.i64(n.last_ping.seconds);
+        w.str(n.depends_on);
+    }
+    w.u32(checksum(out.data(), out.size()));
+    return out;
+}
+
+std::optional<StorageJournal::SnapshotInfo> StorageJournal::decodeSnapshot(std::span<uint8_t const> data, NodeRegistry &out, std::vector<uint32_t> &keys)
+{
+    if (data.size() < 24)
+        return std::nullopt;
+    auto body = data.first(data.size() - 4);
+    if (take(data.data() + body.size(), 4) != checksum(body.data(), body.size()))
+        return std::nullopt;
+
+    Reader r{body};
+    if (r.u32() != kSnapshotMagic)
+        return std::nullopt;
+    auto version = r.u32();
+    if (version < 1 || version > kSnapshotVersion)
+        return std::nullopt;
+    SnapshotInfo info;
+    info.generation = r.u32();
+    info.nextKey = r.u32();
+    auto count = r.u32();
+    out.reserve(count);
+    for (uint32_t i = 0; i < count && r.ok; ++i)
+    {
+        auto key = r.u32();
+        StoredNode n;
+        n.id = r.str();
+        n.name = r.str();
+        n.url = r.str();
+        n.online = r.u8() != 0;
+        n.last_ping.seconds = r.i64();
+        if (version >= 2)
+            n.depends_on = r.str();
+        if (!r.ok || n.id.empty())
+            continue;
+        auto handle = out.upsert(std::move(n));
+        if (keys.size() <= handle.index)
+            keys.resize(handle.index + 1, UINT32_MAX);
+        keys[handle.index] = key;
+    }
+    if (!r.ok)
+        return std::nullopt;
+    return info;
+}
+
+bool StorageJournal::replay(std::filesystem::path const &path, uint32_t generation, std::function<void(Record const &)> const &apply)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+        return false;
+
+    std::array<uint8_t, kHeaderSize> header{};
+    if (!in.read(reinterpret_cast<char *>(header.data()), header.size()) ||
+        header != journalHeader(generation))
+        return false;
+
+    size_t good = kHeaderSize;
+    std::array<uint8_t, kRecordSize> bytes{};
+    while (in.read(reinterpret_cast<char *>(bytes.data()), bytes.size()))
+    {
+        if (take(bytes.data() + 20, 4) != checksum(bytes.data(), 20) ||
+            take(bytes.data() + 16, 4) != generation)
+            break;
+        Record record;
+        record.key = static_cast<uint32_t>(take(bytes.data(), 4));
+        record.online = take(bytes.data() + 4, 4) != 0;
+        record.timestamp = static_cast<int64_t>(take(bytes.data() + 8, 8));
+        apply(record);
+        good += kRecordSize;
+    }
+    in.close();
+
+    std::error_code ec;
+    if (std::filesystem::file_size(path, ec) > good && !ec)
+        std::filesystem::resize_file(path, good, ec);
+    return true;
+}
+
+bool StorageJournal::Appender::open(std::filesystem::path const &path, uint32_t generation)
+{
+    close();
+    std::error_code ec;
+    auto existing = std::filesystem::file_size(path, ec);
+    if (ec)
+        existing = 0;
+
+    m_file.open(path, std::ios::binary | std::ios::app);
+    if (!m_file)
+        return false;
+    if (existing < kHeaderSize)
+    {
+        // a header-only fragment is worthless; start the file over
+        if (existing > 0)
+        {
+            m_file.close();
+            m_file.open(path, std::ios::binary | std::ios::trunc);
+        }
+        auto header = journalHeader(generation);
+        m_file.write(reinterpret_cast<char const *>(header.data()), header.size());
+        m_file.flush();
+        existing = kHeaderSize;
+    }
+    m_generation = generation;
+    m_size = existing - kHeaderSize;
+    return static_cast<bool>(m_file);
+}
+
+void StorageJournal::Appender::close()
+{
+    if (m_file.is_open())
+        m_file.close();
+    m_size = 0;
+}
+
+bool StorageJournal::Appender::append(Record const &record)
+{
+    return append(std::span<Record const>(&record, 1));
+}
+
+bool StorageJournal::Appender::append(std::span<Record const> records)
+{
+    if (!m_file.is_open())
+        return false;
+    for (auto const &record : records)
+    {
+        auto bytes = encodeRecord(record, m_generation);
+        m_file.write(reinterpret_cast<char const *>(bytes.data()), bytes.size());
+    }
+    m_file.flush();
+    if (!m_file)
+        return false;
+    m_size += records.size() * kRecordSize;
+    return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "NodeRegistry.hpp"
+
+// On-disk format of the node store: a snapshot of every node (definition and
+// state) plus append-only journals of state transitions. Journals are
+// numbered by generation; a snapshot of generation G is brought up to date by
+// replaying journals G, G+1, ... in order, so a crash at any point of a
+// compaction still recovers every record that reached the disk.
+namespace StorageJournal
+{
+    // Fixed-size state transition. key is the node's journal key, which is
+    // assigned once per node and kept across snapshots.
+    struct Record
+    {
+        uint32_t key = 0;
+        bool online = false;
+        // epoch seconds
+        int64_t timestamp = 0;
+    };
+
+    static constexpr size_t kRecordSize = 24;
+    static constexpr size_t kHeaderSize = 16;
+
+    std::filesystem::path journalPath(std::filesystem::path const &snapshot, uint32_t generation);
+
+    struct SnapshotInfo
+    {
+        uint32_t generation = 0;
+        // next journal key to hand out
+        uint32_t nextKey = 0;
+    };
+
+    // Serialize the registry in iteration order. keys holds the journal key
+    // of every node, indexed by registry slot.
+    std::vector<uint8_t> encodeSnapshot(SnapshotInfo const &info, NodeRegistry const &nodes, std::span<uint32_t const> keys);
+    // Returns nullopt if the data is truncated or fails its checksum. Nodes
+    // are upserted into out and their keys stored in keys by slot.
+    std::optional<SnapshotInfo> decodeSnapshot(std::span<uint8_t const> data, NodeRegistry &out, std::vector<uint32_t> &keys);
+
+    // Feed every intact record of the journal to apply. A torn or corrupt
+    // tail (crash mid-append) is cut off so later appends stay aligned.
+    // Returns false if the file is missing or belongs to another generation.
+    bool replay(std::filesystem::path const &path, uint32_t generation, std::function<void(Record const &)> const &apply);
+
+    // Append handle for the journal of one generation
+    class Appender
+    {
+        std::ofstream m_file;
+        uint32_t m_generation = 0;
+        size_t m_size = 0;
+
+    public:
+        Appender() = default;
+        Appender(Appender const &) = delete;
+        Appender &operator=(Appender const &) = delete;
+        ~Appender() { close(); }
+
+        // Open for appending; the header is written if the file is new
+        bool open(std::filesystem::path const &path, uint32_t generation);
+        void close();
+        // One fixed-size write, flushed before returning
+        bool append(Record const &record);
+        // Several records with a single flush
+        bool append(std::span<Record const> records);
+
+        bool isOpen() const { return m_file.is_open(); }
+        uint32_t generation() const { return m_generation; }
+        // bytes of records written so far, header excluded
+        size_t size() const { return m_size; }
+    };
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <fmt/format.h>
+#include <array>
+#include <compare>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <string_view>
+
+// Wall-clock time in whole seconds since the Unix epoch. The probe pipeline
+// and storage only ever keep these; text is produced when a label shows it.
+// Durations use std::chrono::steady_clock instead.
+struct EpochTime
+{
+    int64_t seconds = 0;
+
+    static EpochTime now() { return {static_cast<int64_t>(std::time(nullptr))}; }
+    bool valid() const { return seconds > 0; }
+    auto operator<=>(EpochTime const &) const = default;
+};
+
+// Formats EpochTimes as local "YYYY-MM-DD HH:MM:SS" into a reused buffer;
+// formatting the same second again costs nothing
+class TimestampFormatter
+{
+    std::array<char, 32> m_buffer{};
+    int64_t m_cached = -1;
+
+public:
+    // Shared main-thread instance
+    static TimestampFormatter &shared()
+    {
+        static TimestampFormatter instance;
+        return instance;
+    }
+
+    // The result is valid until the next call
+    char const *format(EpochTime time, char const *fallback = "unknown")
+    {
+        if (!time.valid())
+            return fallback;
+        if (time.seconds != m_cached)
+        {
+            auto t = static_cast<std::time_t>(time.seconds);
+            std::tm tm{};
+#ifdef _WIN32
+            localtime_s(&tm, &t);
+#else
+            localtime_r(&t, &tm);
+#endif
+            auto end = fmt::format_to_n(m_buffer.data(), m_buffer.size() - 1, "{:04}-{:02}-{:02} {:02}:{:02}:{:02}",
+                                        tm.tm_year + 1900, tm.tm_mon + 1, tm.tm_mday, tm.tm_hour, tm.tm_min, tm.tm_sec);
+            *end.out = '\0';
+            m_cached = time.seconds;
+        }
+        return m_buffer.data();
+    }
+};
+
+// Parse the old "YYYY-MM-DD HH:MM:SS" local text format (saved values and
+// status.json from before epoch timestamps); invalid when malformed
+inline EpochTime parseLocalTimestamp(std::string_view text)
+{
+    std::tm tm{};
+    std::string buf(text);
+    if (std::sscanf(buf.c_str(), "%d-%d-%d %d:%d:%d", &tm.tm_year, &tm.tm_mon, &tm.tm_mday,
+                    &tm.tm_hour, &tm.tm_min, &tm.tm_sec) != 6)
+        return {};
+    tm.tm_year -= 1900;
+    tm.tm_mon -= 1;
+    tm.tm_isdst = -1;
+    auto time = std::mktime(&tm);
+    return time == static_cast<std::time_t>(-1) ? EpochTime{} : EpochTime{static_cast<int64_t>(time)};
+}
@@ -0,0 +1,77 @@
+#include "TransitionNotifier.hpp"
+
+#include <fmt/format.h>
+
+void TransitionNotifier::report(std::string const &key, std::string_view name, bool up, EpochTime lastOk, Clock::time_point now)
+{
+    auto &service = m_services[key];
+    if (service.name != name)
+        service.name = name;
+    service.up = up;
+    service.lastOk = lastOk;
+    if (service.up == service.notifiedUp || service.pending)
+        return;
+
+    service.pending = true;
+    if (m_pending.empty())
+        m_firstPending = now;
+    m_pending.push_back(key);
+    ++m_stats.transitions;
+}
+
+void TransitionNotifier::forget(std::string const &key)
+{
+    if (m_services.erase(key))
+        std::erase(m_pending, key);
+}
+
+void TransitionNotifier::tick(Clock::time_point now)
+{
+    if (m_pending.empty() || now - m_firstPending < m_window)
+        return;
+    if (m_toasted && now - m_lastToast < m_window)
+        return;
+
+    std::vector<Service const *> down;
+    for (auto const &key : m_pending)
+    {
+        auto &service = m_services[key];
+        service.pending = false;
+        // back where it was before the window, nothing to tell
+        if (service.up == service.notifiedUp)
+        {
+            ++m_stats.coalesced;
+            continue;
+        }
+        service.notifiedUp = service.up;
+        // recoveries only show on the icon
+        if (!service.up)
+            down.push_back(&service);
+    }
+    m_pending.clear();
+    if (down.empty())
+        return;
+
+    std::string message;
+    if (down.size() == 1)
+    {
+        message = fmt::format("Connection Lost to {} at {}", down.front()->name,
+                              TimestampFormatter::shared().format(down.front()->lastOk));
+    }
+    else
+    {
+        message = fmt::format("{} services down: ", down.size());
+        for (size_t i = 0; i < down.size(); ++i)
+        {
+            if (i > 0)
+                message += ", ";
+            message += down[i]->name;
+        }
+    }
+    m_stats.coalesced += down.size() - 1;
+    ++m_stats.toasts;
+    m_toasted = true;
+    m_lastToast = now;
+    if (m_sink)
+        m_sink(message);
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "Timestamp.hpp"
+
+// Turns per-service up/down reports into as few toasts as possible. Only a
+// change of state counts, the changes of one window are summarized in a
+// single toast ("3 services down: ..."), and at most one toast goes out per
+// window, however many services fail. Main thread only.
+class TransitionNotifier
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Sink = std::function<void(std::string const &message)>;
+
+    struct Stats
+    {
+        uint64_t transitions = 0;
+        uint64_t toasts = 0;
+        // transitions folded into a toast about another service, or undone
+        // within the window
+        uint64_t coalesced = 0;
+    };
+
+    void setSink(Sink sink) { m_sink = std::move(sink); }
+    void setWindow(Clock::duration window) { m_window = window; }
+
+    // Latest check result of a service. Services start out as up, so the
+    // first report only counts when it is a failure.
+    void report(std::string const &key, std::string_view name, bool up, EpochTime lastOk, Clock::time_point now = Clock::now());
+    // Drop a service that no longer exists
+    void forget(std::string const &key);
+    // Send the summary once the window of the first pending change passed
+    void tick(Clock::time_point now = Clock::now());
+
+    Stats const &stats() const { return m_stats; }
+
+private:
+    struct Service
+    {
+        std::string name;
+        bool up = true;
+        // state the user was last told about
+        bool notifiedUp = true;
+        bool pending = false;
+        EpochTime lastOk;
+    };
+
+    std::unordered_map<std::string, Service> m_services;
+    // keys with an unannounced change, in the order they changed
+    std::vector<std::string> m_pending;
+    Clock::time_point m_firstPending{};
+    Clock::time_point m_lastToast{};
+    bool m_toasted = false;
+    Clock::duration m_window = std::chrono::seconds(5);
+    Sink m_sink;
+    Stats m_stats;
+};
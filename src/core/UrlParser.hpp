@@ -0,0 +1,170 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+// Parts of an absolute http(s) URL. All views point into the parsed string.
+struct ParsedUrl
+{
+    std::string_view scheme;
+    // host[:port], without any userinfo
+    std::string_view authority;
+    std::string_view host;
+    // explicit port, 0 when absent or not numeric
+    uint16_t port = 0;
+    // up to '?' or '#', may be empty
+    std::string_view path;
+    // after '?' up to '#', may be empty
+    std::string_view query;
+
+    constexpr uint16_t effectivePort() const
+    {
+        if (port)
+            return port;
+        return scheme == "https" ? 443 : 80;
+    }
+};
+
+// Allocation-free URL parser. It accepts exactly what the old validation
+// regex accepted:
+//   (http|https):\/\/([\w_-]+(?:(?:\.[\w_-]+)+))([\w.,@?^=%&:\/~+#-]*[\w@?^=%&\/~+#-])
+// i.e. a dotted host with non-empty labels followed by at least one more
+// character, without the backtracking (or the allocations) of std::regex.
+namespace UrlParser
+{
+    namespace detail
+    {
+        constexpr bool isWord(char c)
+        {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+        }
+
+        constexpr bool isHostChar(char c)
+        {
+            return isWord(c) || c == '-' || c == '.';
+        }
+
+        // [\w@?^=%&\/~+#-], allowed as the last character
+        constexpr bool isTailEnd(char c)
+        {
+            switch (c)
+            {
+            case '@':
+            case '?':
+            case '^':
+            case '=':
+            case '%':
+            case '&':
+            case '/':
+            case '~':
+            case '+':
+            case '#':
+            case '-':
+                return true;
+            default:
+                return isWord(c);
+            }
+        }
+
+        // [\w.,@?^=%&:\/~+#-], allowed anywhere after the host
+        constexpr bool isTail(char c)
+        {
+            return isTailEnd(c) || c == '.' || c == ',' || c == ':';
+        }
+
+        // The regex accepts iff some prefix of the host-character run, short
+        // of the whole string, is a dotted name with non-empty labels
+        constexpr bool hasDottedPrefix(std::string_view s, size_t limit)
+        {
+            bool dot = false;
+            bool prevDot = false;
+            for (size_t i = 0; i < limit; ++i)
+            {
+                if (s[i] == '.')
+                {
+                    // an empty label ends every longer candidate too
+                    if (i == 0 || prevDot)
+                        return false;
+                    dot = prevDot = true;
+                    continue;
+                }
+                prevDot = false;
+                if (dot)
+                    return true;
+            }
+            return false;
+        }
+    }
+
+    constexpr bool isValid(std::string_view url)
+    {
+        using namespace detail;
+        std::string_view rest;
+        if (url.starts_with("https://"))
+            rest = url.substr(8);
+        else if (url.starts_with("http://"))
+            rest = url.substr(7);
+        else
+            return false;
+
+        auto n = rest.size();
+        if (n < 2 || !isTailEnd(rest[n - 1]))
+            return false;
+        size_t run = 0;
+        while (run < n && isHostChar(rest[run]))
+            ++run;
+        for (auto i = run; i < n; ++i)
+        {
+            if (!isTail(rest[i]))
+                return false;
+        }
+        return hasDottedPrefix(rest, run < n ? run : n - 1);
+    }
+
+    constexpr std::optional<ParsedUrl> parse(std::string_view url)
+    {
+        if (!isValid(url))
+            return std::nullopt;
+
+        ParsedUrl out;
+        auto schemeEnd = url.find("://");
+        out.scheme = url.substr(0, schemeEnd);
+        auto rest = url.substr(schemeEnd + 3);
+
+        auto authorityEnd = rest.find_first_of("/?#");
+        if (authorityEnd == std::string_view::npos)
+            authorityEnd = rest.size();
+        auto hostPort = rest.substr(0, authorityEnd);
+        if (auto at = hostPort.rfind('@'); at != std::string_view::npos)
+            hostPort = hostPort.substr(at + 1);
+        out.authority = hostPort;
+        auto colon = hostPort.find(':');
+        out.host = hostPort.substr(0, colon);
+        if (colon != std::string_view::npos)
+        {
+            uint32_t port = 0;
+            auto digits = hostPort.substr(colon + 1);
+            bool numeric = !digits.empty() && digits.size() <= 5;
+            for (char c : digits)
+            {
+                if (c < '0' || c > '9')
+                {
+                    numeric = false;
+                    break;
+                }
+                port = port * 10 + static_cast<uint32_t>(c - '0');
+            }
+            if (numeric && port <= 65535)
+                out.port = static_cast<uint16_t>(port);
+        }
+
+        auto target = rest.substr(authorityEnd);
+        target = target.substr(0, target.find('#'));
+        auto question = target.find('?');
+        out.path = target.substr(0, question);
+        if (question != std::string_view::npos)
+            out.query = target.substr(question + 1);
+        return out;
+    }
+}
@@ -2,11 +2,74 @@
 #include <Geode/modify/MenuLayer.hpp>
 #include <Geode/modify/CCLayer.hpp>
 #include "Geode/ui/OverlayManager.hpp"
+#include <matjson.hpp>
+#include <chrono>
+#include "CoreLog.hpp"
 #include "StatusPopup.hpp"
 #include "StatusMonitor.hpp"
+#include "StatusStorage.hpp"
+#include "Timestamp.hpp"
 
 using namespace geode::prelude;
 
+// status.json from before the journal format
+static bool readLegacyStatus(std::filesystem::path const &path, NodeRegistry &out)
+{
+    auto str = geode::utils::file::readString(path).unwrapOr("");
+    if (str.empty())
+        return false;
+    auto json = matjson::parse(str).unwrapOr(matjson::Value());
+    auto nodesVal = json["nodes"];
+    if (nodesVal.isArray())
+    {
+        out.reserve(nodesVal.size());
+        for (auto const &v : nodesVal)
+        {
+            StoredNode n;
+            n.id = v["id"].asString().unwrapOr("");
+            n.name = v["name"].asString().unwrapOr("");
+            n.url = v["url"].asString().unwrapOr("");
+            n.online = v["online"].asBool().unwrapOr(false);
+            n.last_ping = parseLocalTimestamp(v["last_ping"].asString().unwrapOr(""));
+            if (!n.id.empty())
+                out.upsert(std::move(n));
+        }
+    }
+    return true;
+}
+
+$on_mod(Loaded)
+{
+    // hook the core library up to the mod before anything touches storage
+    CoreLog::setSink([](CoreLog::Level level, std::string_view message) {
+        if (level == CoreLog::Level::Error)
+            log::error("{}", message);
+        else
+            log::info("{}", message);
+    });
+    StatusStorage::setDirectory(Mod::get()->getSaveDir());
+    StatusStorage::setLegacyReader(&readLegacyStatus);
+    // read the custom statuses in the background while the game boots
+    StatusStorage::preload();
+
+    // last_*_ok used to be saved as formatted local time strings; convert them
+    // to epoch seconds once so they can be compared and formatted lazily
+    auto &saved = Mod::get()->getSaveContainer();
+    for (auto key : {"last_internet_ok", "last_boomlings_ok", "last_geode_ok", "last_argon_ok"})
+    {
+        if (!saved.contains(key) || !saved[key].isString())
+            continue;
+        auto time = parseLocalTimestamp(saved[key].asString().unwrapOr(""));
+        Mod::get()->setSavedValue<int64_t>(key, time.seconds);
+    }
+}
+
+// make sure pending custom status changes hit the disk before the game exits
+$on_mod(DataSaved)
+{
+    StatusStorage::flush(true);
+}
+
 class $modify(StatusMenuLayer, MenuLayer)
 {
     bool init()
@@ -60,6 +123,7 @@ class $modify(StatusMenuLayer, MenuLayer)
         // create StatusMonitor if it doesn't exist in the OverlayManager and keep it across scenes
         if (OverlayManager::get()->getChildByIDRecursive("status-monitor") == nullptr)
         {
+            auto started = std::chrono::steady_clock::now();
             if (auto monitor = StatusMonitor::create())
             {
                 monitor->setID("status-monitor");
@@ -67,6 +131,9 @@ class $modify(StatusMenuLayer, MenuLayer)
                 this->addChild(monitor);
                 OverlayManager::get()->addChild(monitor);
             }
+            // what the monitor costs the menu's first frame
+            log::info("status monitor added {}us to MenuLayer::init",
+                      std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started).count());
         }
 
         return true;